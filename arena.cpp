@@ -0,0 +1,80 @@
+//
+// Created by ezzno on 2025/9/16.
+//
+
+#include <algorithm>
+#include <bit>
+
+#include "arena.h"
+
+Arena::Arena() {
+    resource_.emplace(&upstream_);
+}
+
+Arena::~Arena() {
+    destroy();
+}
+
+Arena& Arena::global() {
+    static Arena arena;
+    return arena;
+}
+
+void Arena::destroy() {
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+        it->second(it->first);
+    }
+    destructors_.clear();
+    strings_ = 0;
+}
+
+void Arena::reset() {
+    destroy();
+
+    // 上一轮超出了初始缓冲区：按用量扩大缓冲区，下一轮尽量不再向上游申请
+    size_t used = buffer_size_ + upstream_.bytes();
+    resource_.reset();
+    if (used > buffer_size_ && buffer_size_ < MAX_RETAINED) {
+        buffer_size_ = std::min(std::bit_ceil(used), MAX_RETAINED);
+        buffer_.reset(new std::byte[buffer_size_]);
+    }
+    if (buffer_) {
+        resource_.emplace(buffer_.get(), buffer_size_, &upstream_);
+    } else {
+        resource_.emplace(&upstream_);
+    }
+}
+
+Value StringPool::intern(std::string_view s) {
+    // unordered_set 的元素地址在 rehash 后保持不变
+    return Value::string(&*strings_.emplace(s).first);
+}
+
+Value promote(const Value& value, Arena& arena) {
+    switch (value.type()) {
+        case Value::Type::STRING:
+            return arena.make_string(value.as_string());
+        case Value::Type::ARRAY: {
+            const auto& array = value.as_array();
+            Values* copy = arena.new_array();
+            copy->reserve(array.size());
+            for (const auto& elem : array) {
+                copy->push_back(promote(elem, arena));
+            }
+            return Value::array(copy);
+        }
+        case Value::Type::OBJECT: {
+            const auto& object = value.as_object();
+            ValueMap* copy = arena.new_object();
+            copy->reserve(object.size());
+            for (const auto& [key, elem] : object) {
+                copy->emplace(key, promote(elem, arena));
+            }
+            return Value::object(copy);
+        }
+        case Value::Type::LAZY:  // 复制为普通的数组或对象
+            return promote(materialize(value.as_lazy()), arena);
+        default: // 数值与函数不属于任何分配区
+            return value;
+    }
+}
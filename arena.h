@@ -0,0 +1,139 @@
+//
+// Created by ezzno on 2025/9/16.
+//
+
+#ifndef GLUE_ARENA_H
+#define GLUE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "value.h"
+
+// 数组、对象的分配区：从 monotonic_buffer_resource 顺序分配，reset 时统一析构并释放
+// 在 Arena 中创建的数组、对象使用它的内存资源，元素缓冲区、哈希节点和键也都分配在这里
+// 初始缓冲区在 reset 后保留，并按上一轮的用量增长（最多 MAX_RETAINED），稳定后每个请求不再向全局分配器申请内存
+// 每个请求使用独立的 Arena（非线程安全），进程级的全局值放在 Arena::global() 中
+class Arena {
+private:
+    static constexpr size_t MAX_RETAINED = 1024 * 1024;
+
+    // monotonic_buffer_resource 的上游：向全局分配器申请内存，并统计尚未归还的字节数
+    class Upstream final : public std::pmr::memory_resource {
+        size_t bytes_ = 0;
+
+        void* do_allocate(size_t bytes, size_t align) override {
+            void* p = std::pmr::new_delete_resource()->allocate(bytes, align);
+            bytes_ += bytes;
+            return p;
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            bytes_ -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    public:
+        [[nodiscard]] size_t bytes() const { return bytes_; }
+    };
+
+    std::unique_ptr<std::byte[]> buffer_;  // 初始缓冲区，reset 后保留
+    size_t buffer_size_ = 0;
+    size_t strings_ = 0;                   // 字符串在堆上的缓冲区字节数
+    Upstream upstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+
+    // 需要析构的对象，按分配顺序记录
+    std::vector<std::pair<void*, void (*)(void*)>> destructors_;
+
+    void destroy();
+
+    // 在 arena 中构造对象但不登记析构：仅用于内存全部来自本 arena 的对象
+    template<typename T, typename... Args>
+    T* construct(Args&&... args) {
+        return new (resource_->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 进程生命周期内的分配区（init 中创建的全局值）
+    static Arena& global();
+
+    [[nodiscard]] std::pmr::memory_resource* resource() { return &*resource_; }
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = construct<T>(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            destructors_.emplace_back(object, [](void* p) { static_cast<T*>(p)->~T(); });
+        }
+        return object;
+    }
+
+    Value make_string(std::string s) {
+        if (s.capacity() > std::string().capacity()) {
+            strings_ += s.capacity() + 1;
+        }
+        return Value::string(make<std::string>(std::move(s)));
+    }
+
+    // 新建空的数组、对象，之后直接在其中添加元素
+    // 它们的内存全部来自 arena，reset 时随内存资源一起释放，不需要析构
+    Values* new_array() {
+        return construct<Values>(resource());
+    }
+
+    ValueMap* new_object() {
+        return construct<ValueMap>(resource());
+    }
+
+    // 将已有的容器逐个元素移入 arena
+    Value make_array(Values values) {
+        return Value::array(construct<Values>(std::move(values), resource()));
+    }
+
+    Value make_object(ValueMap object) {
+        return Value::object(construct<ValueMap>(std::move(object), resource()));
+    }
+
+    // 当前占用的内存：初始缓冲区、向上游申请的内存、字符串在堆上的缓冲区，以及析构记录
+    [[nodiscard]] size_t bytes() const {
+        return buffer_size_ + upstream_.bytes() + strings_ + destructors_.capacity() * sizeof(destructors_[0]);
+    }
+
+    // 析构所有对象并释放内存，保留初始缓冲区供下次使用
+    void reset();
+};
+
+// 程序的字符串池（字面量、变量名、字段名）：相同内容返回同一个值
+// 由解析器创建，程序与编译出的模块共同持有，随它们一起释放（--eval 的每次求值各有一个）
+// 只在解析、编译和加载镜像时写入，非线程安全
+class StringPool {
+    std::unordered_set<std::string> strings_;
+
+public:
+    Value intern(std::string_view s);
+};
+
+// 将 value 及其引用的字符串、数组、对象深拷贝到 arena 中
+Value promote(const Value& value, Arena& arena);
+
+#endif // GLUE_ARENA_H
@@ -0,0 +1,36 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+// ro-bench：解码器与运行时的基准测试及解码器的正确性检查，见 bench/README.md
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+
+#include "bench.h"
+
+ABSL_FLAG(int, repeats, 7, "Times each measurement is repeated (best and median are reported)");
+
+int main(int argc, char* argv[]) {
+    std::vector<char*> args = absl::ParseCommandLine(argc, argv);
+    std::string name = args.size() > 1 ? args[1] : "";
+    if (name == "decode") {
+        return bench_decode();
+    }
+    if (name == "path") {
+        return bench_path();
+    }
+    if (name == "check") {
+        return check_decoder();
+    }
+
+    std::cerr << "Usage: " << args[0] << " [--repeats=N] decode|path|check [options]" << std::endl;
+    std::cerr << "  decode: SIMD structural-index decoder vs nlohmann::json on generated documents" << std::endl;
+    std::cerr << "  path:   path access cost for growing array and object sizes" << std::endl;
+    std::cerr << "  check:  decoder results on edge cases vs nlohmann::json, for each SIMD classifier" << std::endl;
+    return 1;
+}
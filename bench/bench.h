@@ -0,0 +1,48 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+#ifndef GLUE_BENCH_H
+#define GLUE_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "absl/flags/declare.h"
+
+#include "arena.h"
+#include "value.h"
+
+// ro-bench 的各项测试共用的重复次数（--repeats）
+ABSL_DECLARE_FLAG(int, repeats);
+
+// 一项测试的耗时（毫秒）：取多次重复中的最小值和中位数
+struct Timing {
+    double best = 0;
+    double median = 0;
+};
+
+// 重复执行 f，每次前先执行 setup（不计时）
+template<typename Setup, typename F>
+Timing measure(int repeats, Setup setup, F f) {
+    std::vector<double> samples;
+    for (int i = 0; i < std::max(repeats, 1); ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        f();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return {samples.front(), samples[samples.size() / 2]};
+}
+
+// nlohmann::json 转换为分配区中的 Value（decode 的对照路径，check 的期望结果）
+Value from_json(const json& j, Arena& arena);
+
+// 各项测试，返回进程的退出码
+int bench_decode();
+int bench_path();
+int check_decoder();
+
+#endif // GLUE_BENCH_H
@@ -0,0 +1,248 @@
+//
+// Created by ezzno on 2025/9/27.
+//
+
+// 解码器正确性检查：依次切换到标量、SSE2、AVX2 字符分类实现，在边界情况上比较 parse_json 与 nlohmann::json 的结果
+// 边界情况：跨越 64 字节块边界的反斜杠序列、转义的引号、1024 层上下的嵌套、截断的输入、超出 int32 的整数
+// 期望结果由 nlohmann 的解析结果按解码器的规则转换（from_json）；嵌套超过 1024 层时期望解析失败
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "bench.h"
+#include "decoder.h"
+
+namespace {
+
+constexpr int MAX_DEPTH = 1024;
+
+struct Case {
+    std::string name;
+    std::string text;
+};
+
+// 数组、对象的嵌套层数
+int depth(const json& j) {
+    int inner = 0;
+    if (j.is_array() || j.is_object()) {
+        for (const auto& elem : j) {
+            inner = std::max(inner, depth(elem));
+        }
+        return inner + 1;
+    }
+    return 0;
+}
+
+// 结构相同：类型一致（int 与 float 不混同），对象按键比较；延迟值先解码
+bool same(const Value& actual, const Value& expected) {
+    if (actual.is_lazy()) {
+        return same(materialize(actual.as_lazy()), expected);
+    }
+    if (actual.type() != expected.type()) {
+        return false;
+    }
+    switch (actual.type()) {
+        case Value::Type::FLOAT:
+            return actual.as_float() == expected.as_float();
+        case Value::Type::STRING:
+            return actual.as_string() == expected.as_string();
+        case Value::Type::ARRAY: {
+            const auto& l = actual.as_array();
+            const auto& r = expected.as_array();
+            if (l.size() != r.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < l.size(); ++i) {
+                if (!same(l[i], r[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        case Value::Type::OBJECT: {
+            const auto& l = actual.as_object();
+            const auto& r = expected.as_object();
+            if (l.size() != r.size()) {
+                return false;
+            }
+            for (const auto& [key, elem] : r) {
+                auto it = l.find(key);
+                if (it == l.end() || !same(it->second, elem)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return actual == expected;
+    }
+}
+
+// 按路径访问：数组的每个元素经由 lazy_element 取得，与完全解码的结果相同
+bool same_by_element(const Value& actual, const Value& expected) {
+    if (!actual.is_lazy() || !expected.is_array()) {
+        return true;
+    }
+    const auto& array = expected.as_array();
+    for (size_t i = 0; i < array.size(); ++i) {
+        Value elem;
+        size_t size = 0;
+        if (!lazy_element(actual.as_lazy(), i, elem, size) || !same(elem, array[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 反斜杠序列：在 64 字节块边界前后的各个位置放置 1..7、63..65、128、129 个反斜杠
+// 奇数个时最后一个转义其后的引号，字符串继续；偶数个时之后的引号结束字符串
+void backslash_runs(std::vector<Case>& cases) {
+    for (size_t run : {1, 2, 3, 4, 5, 6, 7, 63, 64, 65, 128, 129}) {
+        for (size_t pad = 0; pad <= 140; ++pad) {
+            std::string text = "[\"" + std::string(pad, 'a') + std::string(run, '\\') + (run % 2 ? "\"" : "") + "b\", 1]";
+            cases.push_back({"backslash run " + std::to_string(run) + " at " + std::to_string(pad + 2), text});
+        }
+    }
+}
+
+// 转义的引号：键和值中、与结构字符相邻、\u0022 形式，以及跨越块边界的位置
+void escaped_quotes(std::vector<Case>& cases) {
+    const char* const TEXTS[] = {
+        R"({"a\"b": "c\"d"})",
+        R"(["\"", "\\\"", "\\\\", "\"\"\""])",
+        R"({"\"": {"\\": ["\"]", "\",\"", "{\"}"]}})",
+        R"(["\u0022", "a\u005c", "\u005c\u0022"])",
+        R"([{"k": "\"}, {\"k\": 1"}, 2])",
+        R"("\"")",
+    };
+    for (const char* text : TEXTS) {
+        cases.push_back({std::string("escaped quotes ") + text, text});
+    }
+    for (size_t pad = 50; pad <= 70; ++pad) {
+        std::string text = "{\"" + std::string(pad, 'k') + "\\\"\": \"\\\"" + std::string(pad, 'v') + "\\\"\"}";
+        cases.push_back({"escaped quote at " + std::to_string(pad + 2), text});
+    }
+}
+
+// 嵌套：1024 层以内可以解析，超过时解析失败
+void nesting(std::vector<Case>& cases) {
+    for (int levels : {1, 2, 1023, 1024, 1025, 2000}) {
+        std::string arrays = std::string(levels, '[') + std::string(levels, ']');
+        cases.push_back({"nested arrays " + std::to_string(levels), arrays});
+
+        std::string objects;
+        for (int i = 0; i < levels - 1; ++i) {
+            objects += R"({"a": )";
+        }
+        objects += R"({"a": 1})" + std::string(levels - 1, '}');
+        cases.push_back({"nested objects " + std::to_string(levels), objects});
+
+        std::string mixed;
+        for (int i = 0; i < levels; ++i) {
+            mixed += i % 2 ? R"({"k": )" : "[1, ";
+        }
+        for (int i = levels - 1; i >= 0; --i) {
+            mixed += i % 2 ? "}" : "]";
+        }
+        // 最内层为空值
+        mixed.insert(mixed.find_first_of("]}"), "null");
+        cases.push_back({"nested mixed " + std::to_string(levels), mixed});
+    }
+}
+
+// 截断：一个跨越多块、含转义和各类标量的文档的每个前缀
+void truncated(std::vector<Case>& cases) {
+    const std::string text =
+        R"({"id": 2147483648, "name": "user \"42\"", "path": "C:\\dir\\", "tags": ["a", "b\\", "\u00e9\ud83d\ude00"], )"
+        R"("score": -12.5e-3, "active": true, "manager": null, "nested": {"list": [1, [2, [3, {"x": false}]]], )"
+        R"("empty": {}, "none": []}, "tail": "end"})";
+    for (size_t size = 0; size <= text.size(); ++size) {
+        cases.push_back({"truncated to " + std::to_string(size), text.substr(0, size)});
+    }
+}
+
+// 整数：int32 边界两侧、18/19 位、int64 与 uint64 边界两侧，以及跨越块边界的数字
+void integers(std::vector<Case>& cases) {
+    const char* const NUMBERS[] = {
+        "0", "-0", "2147483647", "-2147483648", "2147483648", "-2147483649", "4294967296", "-4294967296",
+        "999999999999999999", "-999999999999999999", "1000000000000000000", "1234567890123456789",
+        "9223372036854775807", "-9223372036854775808", "9223372036854775808", "-9223372036854775809",
+        "18446744073709551615", "18446744073709551616", "100000000000000000000000",
+    };
+    std::string all = "[";
+    for (const char* number : NUMBERS) {
+        cases.push_back({std::string("integer ") + number, number});
+        all += std::string(all.size() > 1 ? ", " : "") + number;
+    }
+    cases.push_back({"integers", all + "]"});
+    for (size_t pad = 50; pad <= 66; ++pad) {
+        cases.push_back({"integer at " + std::to_string(pad + 1), "[" + std::string(pad, ' ') + "2147483648, -2147483649]"});
+    }
+}
+
+// 单个用例：返回空字符串表示一致，否则为不一致之处
+std::string check(const Case& c) {
+    Arena arena;
+    json parsed = json::parse(c.text, nullptr, false);
+    bool valid = !parsed.is_discarded() && depth(parsed) <= MAX_DEPTH;
+
+    Value actual = parse_json(c.text, arena);
+    if (!valid) {
+        // 解析失败时为空值（int 0）
+        return actual == NULL_VALUE ? "" : "accepted invalid input";
+    }
+
+    Value expected = from_json(parsed, arena);
+    if (!same_by_element(parse_json(c.text, arena), expected)) {
+        return "lazy_element differs from nlohmann";
+    }
+    if (!same(actual, expected)) {
+        return "decoded value differs from nlohmann";
+    }
+    return "";
+}
+
+} // namespace
+
+int check_decoder() {
+    std::vector<Case> cases;
+    backslash_runs(cases);
+    escaped_quotes(cases);
+    nesting(cases);
+    truncated(cases);
+    integers(cases);
+
+    const std::pair<JsonClassifier, const char*> CLASSIFIERS[] = {
+        {JsonClassifier::SCALAR, "scalar"},
+        {JsonClassifier::SSE2, "sse2"},
+        {JsonClassifier::AVX2, "avx2"},
+    };
+
+    int failures = 0;
+    for (const auto& [classifier, name] : CLASSIFIERS) {
+        if (!use_json_classifier(classifier)) {
+            std::printf("%-8s not supported by this CPU, skipped\n", name);
+            continue;
+        }
+        int failed = 0;
+        for (const auto& c : cases) {
+            std::string error = check(c);
+            if (!error.empty()) {
+                // 只输出前几个，文本过长时截断
+                if (failed < 10) {
+                    std::printf("%-8s FAIL %s: %s\n         %.120s\n", name, c.name.c_str(), error.c_str(),
+                                c.text.c_str());
+                }
+                ++failed;
+            }
+        }
+        std::printf("%-8s %zu cases, %d failed\n", name, cases.size(), failed);
+        failures += failed;
+    }
+    use_json_classifier(JsonClassifier::AUTO);
+    return failures ? 1 : 0;
+}
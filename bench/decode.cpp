@@ -0,0 +1,218 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+// 解码器基准：结构索引解码器（decoder.h）与 nlohmann::json 解析后转换为 Value 的对比
+// 文档由固定种子的生成器产生（--size_mb 控制大小，--write_dir 可写出到文件），也可以用 --input 指定 JSON 文件
+// 每个文档先比较两种方式解码出的值，一致后再计时
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/strings/str_split.h"
+
+#include "arena.h"
+#include "bench.h"
+#include "decoder.h"
+
+ABSL_FLAG(double, size_mb, 4, "Approximate size in MiB of each generated document");
+ABSL_FLAG(std::string, input, "", "Comma-separated JSON files to decode instead of the generated documents");
+ABSL_FLAG(std::string, write_dir, "", "Write the generated documents to this directory and exit");
+
+namespace {
+
+struct Document {
+    std::string name;
+    std::string text;
+};
+
+// 生成器：按种类追加一个元素，直到文档达到指定大小
+std::string generate(size_t bytes, const std::function<void(std::string&, std::mt19937&)>& element) {
+    std::mt19937 random(42);
+    std::string text = "[";
+    while (text.size() < bytes) {
+        if (text.size() > 1) {
+            text += ", ";
+        }
+        element(text, random);
+    }
+    text += "]";
+    return text;
+}
+
+std::vector<Document> generated_documents(size_t bytes) {
+    std::vector<Document> documents;
+
+    // 整数数组（计数器、ID 列表）
+    documents.push_back({"integers", generate(bytes, [](std::string& out, std::mt19937& random) {
+        out += std::to_string(std::uniform_int_distribution<int>(-1000000, 1000000)(random));
+    })});
+
+    // 浮点数组（指标、坐标）
+    documents.push_back({"floats", generate(bytes, [](std::string& out, std::mt19937& random) {
+        char buffer[32];
+        double value = std::uniform_real_distribution<double>(-1e4, 1e4)(random);
+        out.append(buffer, std::snprintf(buffer, sizeof(buffer), random() % 4 ? "%.6f" : "%.4e", value));
+    })});
+
+    // 对象数组（列表接口返回的记录）
+    documents.push_back({"records", generate(bytes, [](std::string& out, std::mt19937& random) {
+        static const char* const CITIES[] = {"Beijing", "Shanghai", "Shenzhen", "Hangzhou", "Chengdu"};
+        auto id = std::to_string(random() % 1000000);
+        out += R"({"id": )" + id + R"(, "name": "user-)" + id + R"(", "email": "user)" + id + R"(@example.com", )";
+        out += R"("active": )" + std::string(random() % 2 ? "true" : "false");
+        out += R"(, "score": )" + std::to_string((random() % 10000) / 100.0);
+        out += R"(, "tags": ["a", "b", "c"], "address": {"city": ")" + std::string(CITIES[random() % 5]);
+        out += R"(", "zip": ")" + std::to_string(100000 + random() % 900000) + R"("}, "manager": null})";
+    })});
+
+    // 含转义的字符串数组（文本内容）
+    documents.push_back({"escaped", generate(bytes, [](std::string& out, std::mt19937& random) {
+        static const char* const PIECES[] = {"plain text ", "\\\"quoted\\\" ", "line\\nbreak ", "tab\\there ",
+                                             "back\\\\slash ", "caf\\u00e9 ", "\\ud83d\\ude00 "};
+        out += '"';
+        for (int i = 0; i < 4; ++i) {
+            out += PIECES[random() % 7];
+        }
+        out += '"';
+    })});
+    return documents;
+}
+
+std::vector<Document> input_documents(const std::string& files) {
+    std::vector<Document> documents;
+    std::vector<std::string> paths = absl::StrSplit(files, ',', absl::SkipEmpty());
+    for (const auto& file : paths) {
+        std::ifstream in(file);
+        if (!in) {
+            throw std::runtime_error("cannot read " + file);
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        documents.push_back({std::filesystem::path(file).filename().string(), buffer.str()});
+    }
+    return documents;
+}
+
+// 完全解码延迟值（与遍历、序列化整个文档的开销相同）
+void decode_all(const Value& value) {
+    Value decoded = value.is_lazy() ? materialize(value.as_lazy()) : value;
+    if (decoded.is_array()) {
+        for (const auto& elem : decoded.as_array()) {
+            decode_all(elem);
+        }
+    } else if (decoded.is_object()) {
+        for (const auto& [key, elem] : decoded.as_object()) {
+            decode_all(elem);
+        }
+    }
+}
+
+} // namespace
+
+// nlohmann 的路径：解析为 json，再逐层转换为分配区中的 Value（原 json_to_value 的做法）
+// 整数按解码器的规则转换：超出 int 范围的整数为 float
+Value from_json(const json& j, Arena& arena) {
+    switch (j.type()) {
+        case json::value_t::boolean:
+            return j.get<bool>();
+        case json::value_t::number_integer:
+            if (j.get<int64_t>() >= INT32_MIN && j.get<int64_t>() <= INT32_MAX) {
+                return static_cast<int>(j.get<int64_t>());
+            }
+            return static_cast<float>(j.get<double>());
+        case json::value_t::number_unsigned:
+            if (j.get<uint64_t>() <= INT32_MAX) {
+                return static_cast<int>(j.get<uint64_t>());
+            }
+            return static_cast<float>(j.get<double>());
+        case json::value_t::number_float:
+            return static_cast<float>(j.get<double>());
+        case json::value_t::string:
+            return arena.make_string(j.get<std::string>());
+        case json::value_t::array: {
+            Values* array = arena.new_array();
+            array->reserve(j.size());
+            for (const auto& elem : j) {
+                array->push_back(from_json(elem, arena));
+            }
+            return Value::array(array);
+        }
+        case json::value_t::object: {
+            ValueMap* object = arena.new_object();
+            object->reserve(j.size());
+            for (const auto& [key, elem] : j.items()) {
+                object->emplace(key, from_json(elem, arena));
+            }
+            return Value::object(object);
+        }
+        default:
+            return NULL_VALUE;
+    }
+}
+
+int bench_decode() {
+    const auto bytes = static_cast<size_t>(absl::GetFlag(FLAGS_size_mb) * 1024 * 1024);
+    const int repeats = absl::GetFlag(FLAGS_repeats);
+
+    std::vector<Document> documents;
+    try {
+        documents = absl::GetFlag(FLAGS_input).empty() ? generated_documents(bytes)
+                                                       : input_documents(absl::GetFlag(FLAGS_input));
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (const auto dir = absl::GetFlag(FLAGS_write_dir); !dir.empty()) {
+        for (const auto& doc : documents) {
+            std::ofstream(dir + "/" + doc.name + ".json") << doc.text;
+            std::cout << "Wrote " << dir << "/" << doc.name << ".json (" << doc.text.size() << " bytes)" << std::endl;
+        }
+        return 0;
+    }
+
+    std::printf("%-16s %9s %22s %22s %22s\n", "document", "MB", "nlohmann+convert ms", "index (lazy) ms",
+                "index+decode all ms");
+    std::printf("%-16s %9s %22s %22s %22s\n", "", "", "best / median", "best / median", "best / median");
+    Arena arena;
+    for (const auto& doc : documents) {
+        // 两种方式的结果须一致（对象按键比较，与成员顺序无关）
+        {
+            Arena expected_arena;
+            Value expected = from_json(json::parse(doc.text), expected_arena);
+            Value actual = parse_json(doc.text, arena);
+            decode_all(actual);
+            json l, r;
+            to_json(l, expected);
+            to_json(r, actual);
+            if (l != r) {
+                std::cerr << doc.name << ": decoders disagree" << std::endl;
+                return 1;
+            }
+            arena.reset();
+        }
+
+        std::string text;
+        auto reset = [&] {
+            arena.reset();
+            text = doc.text;
+        };
+        Timing nlohmann = measure(repeats, reset, [&] { from_json(json::parse(text), arena); });
+        Timing lazy = measure(repeats, reset, [&] { parse_json(std::move(text), arena); });
+        Timing full = measure(repeats, reset, [&] { decode_all(parse_json(std::move(text), arena)); });
+        std::printf("%-16s %9.1f %10.1f / %-9.1f %10.1f / %-9.1f %10.1f / %-9.1f\n", doc.name.c_str(),
+                    doc.text.size() / 1048576.0, nlohmann.best, nlohmann.median, lazy.best, lazy.median, full.best,
+                    full.median);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+// 回环压测：每个连接一个线程，在 keep-alive 连接上循环发送同一个 GET 请求
+// 预热之后开始计数，结束时输出吞吐、延迟分位数和错误数（一行，便于脚本汇总）
+// 服务端关闭连接（keep_alive_requests 用完、Connection: close）时重新连接，不计为错误
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+
+ABSL_FLAG(std::string, host, "127.0.0.1", "IPv4 address of the server");
+ABSL_FLAG(int, port, 8080, "Port of the server");
+ABSL_FLAG(std::string, path, "/", "Request target sent on every request");
+ABSL_FLAG(int, connections, 64, "Concurrent keep-alive connections (one thread each)");
+ABSL_FLAG(double, duration, 10, "Seconds to measure");
+ABSL_FLAG(double, warmup, 1, "Seconds to run before measuring");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    long requests = 0;
+    long errors = 0;                 // 非 2xx 响应
+    long reconnects = 0;
+    std::vector<uint32_t> latencies; // 微秒
+};
+
+int open_connection(const sockaddr_in& address) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        perror("connect");
+        std::exit(1);
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// 读取一个完整的响应（只支持 Content-Length），连接关闭时返回 false
+bool read_response(int fd, std::string& buffer, int& status, bool& close) {
+    buffer.clear();
+    char chunk[16 * 1024];
+    size_t header_end = std::string::npos;
+    size_t length = 0;
+    while (true) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, n);
+        if (header_end == std::string::npos) {
+            header_end = buffer.find("\r\n\r\n");
+            if (header_end == std::string::npos) {
+                continue;
+            }
+            std::string_view header(buffer.data(), header_end);
+            status = std::atoi(buffer.c_str() + header.find(' ') + 1);
+            auto field = header.find("Content-Length: ");
+            length = field == std::string_view::npos ? 0 : std::strtoul(buffer.c_str() + field + 16, nullptr, 10);
+            close = header.find("Connection: close") != std::string_view::npos;
+        }
+        if (buffer.size() >= header_end + 4 + length) {
+            return true;
+        }
+    }
+}
+
+void run(const sockaddr_in& address, const std::string& request, const std::atomic<int>& phase, Result& result) {
+    int fd = open_connection(address);
+    std::string buffer;
+    while (phase.load(std::memory_order_relaxed) < 2) {
+        auto start = Clock::now();
+        int status = 0;
+        bool close = false;
+        if (write(fd, request.data(), request.size()) != static_cast<ssize_t>(request.size()) ||
+            !read_response(fd, buffer, status, close)) {
+            ::close(fd);
+            fd = open_connection(address);
+            ++result.reconnects;
+            continue;
+        }
+        if (phase.load(std::memory_order_relaxed) == 1) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+            result.latencies.push_back(static_cast<uint32_t>(elapsed.count()));
+            ++result.requests;
+            if (status < 200 || status >= 300) {
+                ++result.errors;
+            }
+        }
+        if (close) {
+            ::close(fd);
+            fd = open_connection(address);
+            ++result.reconnects;
+        }
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    absl::ParseCommandLine(argc, argv);
+    const std::string path = absl::GetFlag(FLAGS_path);
+    const int connections = std::max(absl::GetFlag(FLAGS_connections), 1);
+    const double duration = std::max(absl::GetFlag(FLAGS_duration), 0.1);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(absl::GetFlag(FLAGS_port)));
+    if (inet_pton(AF_INET, absl::GetFlag(FLAGS_host).c_str(), &address.sin_addr) != 1) {
+        std::fprintf(stderr, "invalid host: %s\n", absl::GetFlag(FLAGS_host).c_str());
+        return 1;
+    }
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + absl::GetFlag(FLAGS_host) + "\r\n\r\n";
+
+    // 0 预热，1 计数，2 结束
+    std::atomic<int> phase{0};
+    std::vector<Result> results(connections);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; ++i) {
+        threads.emplace_back(run, std::cref(address), std::cref(request), std::cref(phase), std::ref(results[i]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(absl::GetFlag(FLAGS_warmup)));
+    phase = 1;
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+    phase = 2;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Result total;
+    for (auto& result : results) {
+        total.requests += result.requests;
+        total.errors += result.errors;
+        total.reconnects += result.reconnects;
+        total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    auto percentile = [&](double p) -> uint32_t {
+        if (total.latencies.empty()) {
+            return 0;
+        }
+        auto nth = total.latencies.begin() + static_cast<long>(p * (total.latencies.size() - 1));
+        std::nth_element(total.latencies.begin(), nth, total.latencies.end());
+        return *nth;
+    };
+    std::printf("%s connections=%d req/s=%.0f p50=%uus p99=%uus errors=%ld reconnects=%ld\n", path.c_str(),
+                connections, total.requests / duration, percentile(0.5), percentile(0.99), total.errors,
+                total.reconnects);
+    return 0;
+}
@@ -0,0 +1,156 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+// 路径访问基准：按路径读取数组元素、对象字段的耗时应与容器大小无关（读取不复制容器）
+// interpreter：init 中构建 N 个元素的数组和 N 个字段的对象，只对按路径读取它们的 api 计时
+// lazy：上游 JSON 文档（<- 的结果）上的 data.msg.arr[1]，与执行器一样经由 lazy_field / lazy_element
+//       分别给出建立索引、首次访问（只扫描到目标位置）和之后每次访问（已解码的一层上查找）的耗时
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/strings/str_split.h"
+
+#include "arena.h"
+#include "bench.h"
+#include "compiler.h"
+#include "decoder.h"
+#include "executor.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+
+ABSL_FLAG(std::string, sizes, "10,1000,100000,1000000", "Comma-separated container sizes");
+ABSL_FLAG(int, iterations, 200000, "Loop iterations (path accesses) timed for each size");
+
+namespace {
+
+// 每次循环按路径读取三次：嵌套对象中的数组元素、对象字段、数组的最后一个元素
+// 第 i 个元素（字段 ki）的值为 i % 10，累加的结果不会溢出
+std::string program(size_t size, int iterations) {
+    std::string source = "listen 9400\ninit() {\n    arr = [";
+    for (size_t i = 0; i < size; ++i) {
+        source += (i ? ", " : "") + std::to_string(i % 10);
+    }
+    source += "];\n    obj = {";
+    for (size_t i = 0; i < size; ++i) {
+        source += (i ? ", \"k" : "\"k") + std::to_string(i) + "\": " + std::to_string(i % 10);
+    }
+    source += "};\n    doc = {\"data\": {\"msg\": {\"arr\": arr, \"obj\": obj}}};\n}\n";
+    source += "api \"/walk\" {\n    s = 0;\n    i = 0;\n    while (i < " + std::to_string(iterations) + ") {\n";
+    source += "        s = s + doc.data.msg.arr.1 + doc[\"data\"][\"msg\"][\"obj\"][\"k" + std::to_string(size / 2) +
+              "\"] + arr[" + std::to_string(size - 1) + "];\n";
+    source += "        i = i + 1;\n    }\n    return s;\n}\n";
+    return source;
+}
+
+std::string document(size_t size) {
+    std::string text = R"({"data": {"msg": {"arr": [)";
+    for (size_t i = 0; i < size; ++i) {
+        text += (i ? ", " : "") + std::to_string(i);
+    }
+    return text + R"(], "tail": "end"}}})";
+}
+
+double elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int bench_path() {
+    const int repeats = absl::GetFlag(FLAGS_repeats);
+    const int iterations = std::max(absl::GetFlag(FLAGS_iterations), 1);
+    std::vector<size_t> sizes;
+    for (const std::string& size : std::vector<std::string>(absl::StrSplit(absl::GetFlag(FLAGS_sizes), ','))) {
+        sizes.push_back(std::max<size_t>(std::stoul(size), 2));
+    }
+
+    std::printf("interpreter: ns per loop iteration (3 path accesses), best / median of %d\n", repeats);
+    std::printf("%12s %22s\n", "size", "ns / iteration");
+    for (size_t size : sizes) {
+        // 与 eval 模式相同地编译并执行 init，全局变量中的容器在 api 执行期间保持不变
+        Lexer lexer(program(size, iterations), true);
+        Parser parser(lexer);
+        std::unique_ptr<ProgramNode> program = parser.parse_program();
+        Arena arena;
+        Optimizer().run(*program, arena);
+        std::shared_ptr<const Module> module = Compiler().compile(*program);
+        Executor init(true, arena);
+        init.execute(program, module);
+
+        Executor walk = init.copy();
+        walk.use_arena(arena);
+        Router::Match match;
+        match.api = program->apis.front().get();
+
+        // 每次循环累加 arr[1]、obj 中间的字段和 arr 的最后一个元素
+        const auto expected = iterations * static_cast<int>(1 + (size / 2) % 10 + (size - 1) % 10);
+        Value result;
+        Timing timing = measure(repeats, [] {}, [&] {
+            if (!walk.execute_api(match, result) || !(result == Value(expected))) {
+                std::fprintf(stderr, "size %zu: unexpected result %s\n", size, value_to_string(result).c_str());
+                std::exit(1);
+            }
+        });
+        std::printf("%12zu %10.1f / %-9.1f\n", size, timing.best * 1e6 / iterations,
+                    timing.median * 1e6 / iterations);
+    }
+
+    std::printf("\nlazy: data.msg.arr[1] on an upstream document, through lazy_field / lazy_element\n");
+    std::printf("%12s %14s %14s %14s\n", "size", "index ms", "first ns", "repeat ns");
+    Arena arena;
+    for (size_t size : sizes) {
+        const std::string text = document(size);
+        double index = 0, first = 0, repeat = 0;
+        for (int r = 0; r < std::max(repeats, 1); ++r) {
+            arena.reset();
+            auto start = std::chrono::steady_clock::now();
+            Value root = parse_json(text, arena);
+            double index_ns = elapsed_ns(start);
+
+            auto access = [&] {
+                Value data, msg, arr, elem;
+                size_t length = 0;
+                if (!lazy_field(root.as_lazy(), "data", data) || !lazy_field(data.as_lazy(), "msg", msg) ||
+                    !lazy_field(msg.as_lazy(), "arr", arr) || !lazy_element(arr.as_lazy(), 1, elem, length) ||
+                    elem.as_int() != 1) {
+                    std::fprintf(stderr, "size %zu: wrong element\n", size);
+                    std::exit(1);
+                }
+            };
+            start = std::chrono::steady_clock::now();
+            access();
+            double first_ns = elapsed_ns(start);
+
+            // 每层在第二次被访问时解码，再访问四次后整条路径都在解码的容器上查找
+            for (int i = 0; i < 4; ++i) {
+                access();
+            }
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                access();
+            }
+            double repeat_ns = elapsed_ns(start) / iterations;
+
+            if (r == 0 || index_ns < index) {
+                index = index_ns;
+            }
+            if (r == 0 || first_ns < first) {
+                first = first_ns;
+            }
+            if (r == 0 || repeat_ns < repeat) {
+                repeat = repeat_ns;
+            }
+        }
+        std::printf("%12zu %14.2f %14.0f %14.1f\n", size, index / 1e6, first, repeat);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+#
+# 按 reactor 数量测回环吞吐：依次以 --reactors=1,2,4,N 启动 ro-glue，对 /hello 和 /work 各压测一轮
+# 用法：bench/reactors.sh [构建目录] [每轮秒数] [连接数]
+# 有 taskset 且核数不少于 2 时，服务端绑定前一半核，压测端绑定后一半核，避免两者争用同一批核
+#
+set -euo pipefail
+
+BUILD=${1:-build}
+SECONDS_PER_RUN=${2:-10}
+CONNECTIONS=${3:-64}
+HERE=$(cd "$(dirname "$0")" && pwd)
+PORT=9300
+CORES=$(nproc)
+
+SERVER_CPUS=""
+CLIENT_CPUS=""
+if command -v taskset >/dev/null && [ "$CORES" -ge 2 ]; then
+    HALF=$((CORES / 2))
+    SERVER_CPUS="taskset -c 0-$((HALF - 1))"
+    CLIENT_CPUS="taskset -c $HALF-$((CORES - 1))"
+    SERVER_CORES=$HALF
+else
+    SERVER_CORES=$CORES
+    echo "# $CORES core(s): server and load generator share the same cores" >&2
+fi
+
+# 1、2、4 以及服务端可用的核数，去重
+COUNTS=$(printf '%s\n' 1 2 4 "$SERVER_CORES" | sort -n -u)
+
+echo "reactors path req/s p50 p99 errors"
+for reactors in $COUNTS; do
+    $SERVER_CPUS "$BUILD/ro-glue" --reactors="$reactors" --workers="$reactors" "$HERE/reactors.ro" >/dev/null 2>&1 &
+    server=$!
+    for _ in $(seq 50); do
+        (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null && break
+        sleep 0.1
+    done
+
+    for path in /hello /work; do
+        line=$($CLIENT_CPUS "$BUILD/ro-load" --port="$PORT" --path="$path" --connections="$CONNECTIONS" \
+            --duration="$SECONDS_PER_RUN")
+        # /hello connections=64 req/s=12345 p50=100us p99=900us errors=0 reconnects=0
+        echo "$reactors $line" | sed -E 's/ connections=[0-9]+//; s/ reconnects=[0-9]+//; s/[a-z0-9/]+=//g'
+    done
+
+    kill "$server"
+    wait "$server" 2>/dev/null || true
+done
@@ -0,0 +1,100 @@
+//
+// Created by ezzno on 2025/9/12.
+//
+
+#ifndef GLUE_BYTECODE_H
+#define GLUE_BYTECODE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "parser.h"
+#include "value.h"
+
+// 字节码指令集（基于栈的虚拟机）
+enum class OpCode : uint8_t {
+    CONST,          // 压入常量 constants[a]
+    LOAD_LOCAL,     // 压入局部变量 a（参数依次占用前几个槽位）
+    STORE_LOCAL,    // 将栈顶写入局部变量 a（不出栈）
+    LOAD_GLOBAL,    // 压入全局变量 constants[a]
+    STORE_GLOBAL,   // 将栈顶写入全局变量 constants[a]（不出栈）
+    POP,            // 弹出栈顶
+    FIELD,          // 栈顶对象取字段 constants[a]
+    ELEMENT,        // 栈顶数组取第 a 个元素
+    INDEX,          // 弹出索引和容器，压入对应元素
+    CALL,           // 调用参数（a 个）下方的函数
+    ADD, SUB, MUL, DIV,
+    EQ, NEQ, LT, GT, LE, GE,
+    AND, OR, NOT,
+    ARRAY,          // 弹出 a 个元素构造数组
+    OBJECT,         // 弹出 a 组键值对构造对象
+    CURL,           // 弹出url，压入请求结果（b=1 时 url 上方还有缓存时长）
+    FETCH,          // 弹出url，发出请求，结果在 AWAIT 时写入局部变量 a（b 同 CURL）
+    AWAIT,          // 等待之前 FETCH 的请求全部完成
+    JUMP,           // 跳转到 a
+    JUMP_IF_FALSE,  // 弹出条件，为false时跳转到 a（b=1 时非bool视为false，否则报错）
+    EACH,           // 遍历栈顶 [数组, i, j] 的下一组元素对并压入，结束时弹出迭代状态并跳转到 a
+    PRINT,          // 弹出 a 个值并打印
+    RETURN,         // 弹出返回值并返回调用者
+};
+
+// 单条指令：操作码 + 两个操作数
+struct Instruction {
+    OpCode op;
+    int32_t a = 0;
+    int32_t b = 0;
+};
+
+// 代码块：指令流 + 常量池
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+
+    [[nodiscard]] std::string to_string(int indent = 0) const;
+};
+
+// JIT 生成的本地代码：参数均为int，ok 置 0 表示需要回退到解释器
+using NativeFunction = int32_t (*)(const int32_t* args, int32_t* ok);
+
+// 编译后的函数（api 也被编译为无参函数）
+struct Function {
+    std::string name;
+    Parameters parameters;
+    Chunk chunk;
+    bool global_scope = false;  // init 函数：变量直接写入全局变量表
+
+    // 局部变量槽位的名称（参数在前），调用时在操作数栈上分配
+    std::vector<std::string> slots;
+
+    // JIT 状态（请求线程间共享）
+    mutable std::atomic<uint32_t> hits{0};
+    mutable std::atomic<NativeFunction> native{nullptr};
+
+    // 调度状态（请求线程间共享）：api 执行耗时的滑动平均（纳秒），UINT32_MAX 表示未知或会在 <- 处挂起
+    mutable std::atomic<uint32_t> cost_ns{UINT32_MAX};
+
+    [[nodiscard]] std::string to_string(int indent = 0) const;
+};
+
+// 编译后的整个程序
+struct Module {
+    std::vector<std::unique_ptr<Function>> functions;
+    std::unordered_map<const APINode*, std::unique_ptr<Function>> apis;
+
+    // 常量引用的字符串（字面量与名称），与 ProgramNode 共享
+    std::shared_ptr<StringPool> strings = std::make_shared<StringPool>();
+
+    // JIT 生成的本地代码（执行引擎）的所有者，随模块一起释放；由 Jit 持锁写入
+    mutable std::vector<std::shared_ptr<void>> native_code;
+
+    [[nodiscard]] std::string to_string(int indent = 0) const;
+};
+
+const char* opcode_name(OpCode op);
+
+#endif // GLUE_BYTECODE_H
@@ -0,0 +1,121 @@
+//
+// Created by ezzno on 2025/9/21.
+//
+
+#include <functional>
+
+#include "cache.h"
+#include "decoder.h"
+
+ResponseCache& ResponseCache::instance() {
+    static ResponseCache cache;
+    return cache;
+}
+
+ResponseCache::Shard& ResponseCache::shard(const std::string& url) {
+    return shards_[std::hash<std::string>{}(url) % SHARDS];
+}
+
+void ResponseCache::erase(Shard& shard, std::list<std::shared_ptr<Entry>>::iterator it) {
+    size_ -= (*it)->size;
+    shard.index.erase((*it)->url);
+    shard.lru.erase(it);
+}
+
+std::shared_ptr<ResponseCache::Entry> ResponseCache::make_entry(const std::string& url, const std::string& body) {
+    // 先得到延迟值，再完全解码到条目的分配区中
+    auto entry = std::make_shared<Entry>();
+    entry->url = url;
+    Arena scratch;
+    entry->value = promote(parse_json(body, scratch), entry->arena);
+    entry->size = sizeof(Entry) + entry->url.capacity() + entry->arena.bytes();
+    return entry;
+}
+
+std::shared_ptr<const Value> ResponseCache::decode(const std::string& body) {
+    auto entry = make_entry({}, body);
+    return {entry, &entry->value};
+}
+
+std::shared_ptr<const Value> ResponseCache::lookup(const std::string& url) {
+    if (capacity_ == 0) {
+        return nullptr;
+    }
+
+    Shard& shard = this->shard(url);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(url);
+    if (found == shard.index.end()) {
+        return nullptr;
+    }
+    auto it = found->second;
+    auto now = Clock::now();
+    if ((*it)->expires <= now) {
+        erase(shard, it);
+        return nullptr;
+    }
+
+    (*it)->used = now;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+    const std::shared_ptr<Entry>& entry = *it;
+    return {entry, &entry->value};
+}
+
+std::shared_ptr<const Value> ResponseCache::store(const std::string& url, const std::string& body,
+                                                  std::chrono::seconds ttl) {
+    // 解码后的值通常比响应体大，响应体已经超过容量时不再解码
+    const size_t limit = capacity_;
+    if (ttl.count() <= 0 || body.size() > limit) {
+        return nullptr;
+    }
+
+    // 在锁外解码，按解码后实际占用的内存计入容量
+    auto entry = make_entry(url, body);
+    if (entry->size > limit) {
+        return nullptr;
+    }
+    entry->used = Clock::now();
+    entry->expires = entry->used + ttl;
+
+    {
+        Shard& shard = this->shard(url);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto found = shard.index.find(url);
+        if (found != shard.index.end()) {
+            erase(shard, found->second);
+        }
+        shard.lru.push_front(entry);
+        shard.index[entry->url] = shard.lru.begin();
+        size_ += entry->size;
+    }
+
+    evict(entry.get());
+    return {entry, &entry->value};
+}
+
+void ResponseCache::evict(const Entry* keep) {
+    while (size_ > capacity_) {
+        // 各分片的 LRU 末尾是分片内最久未使用的条目，取其中最旧的
+        Shard* oldest = nullptr;
+        Clock::time_point oldest_used;
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!shard.lru.empty() && shard.lru.back().get() != keep &&
+                (!oldest || shard.lru.back()->used < oldest_used)) {
+                oldest = &shard;
+                oldest_used = shard.lru.back()->used;
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+
+        // 其间末尾的条目可能已被命中或移除，下一轮重新选择
+        std::lock_guard<std::mutex> lock(oldest->mutex);
+        if (!oldest->lru.empty() && oldest->lru.back().get() != keep && oldest->lru.back()->used == oldest_used) {
+            erase(*oldest, std::prev(oldest->lru.end()));
+        }
+    }
+}
@@ -0,0 +1,84 @@
+//
+// Created by ezzno on 2025/9/21.
+//
+
+#ifndef GLUE_CACHE_H
+#define GLUE_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "arena.h"
+#include "value.h"
+
+// 上游响应缓存（<- 使用）：按 URL 缓存已解码的值，进程内共享，命中时跳过网络请求和 JSON 解码
+// 按 URL 的哈希分片加锁，总大小超过上限时跨分片淘汰：每次淘汰各分片最久未使用的条目中最旧的一个
+// 单个条目只要不超过总上限就可以缓存
+// 条目的大小是解码后实际占用的内存：条目本身、URL，以及分配区中的数组、对象、哈希节点和字符串（见 Arena::bytes）
+// 值在条目自己的分配区中完全解码（不含延迟值），之后只读，可以被多个请求同时引用
+class ResponseCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct Entry {
+        std::string url;
+        Arena arena;
+        Value value;
+        Clock::time_point expires;
+        Clock::time_point used;  // 最近一次存入或命中的时间（持有分片的锁时读写）
+        size_t size = 0;         // 计入缓存上限的字节数
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::shared_ptr<Entry>> lru;  // 最近使用的在前面
+        std::unordered_map<std::string_view, std::list<std::shared_ptr<Entry>>::iterator> index;
+    };
+
+    static constexpr size_t SHARDS = 16;
+
+    std::array<Shard, SHARDS> shards_;
+    std::atomic<size_t> capacity_{64 * 1024 * 1024};
+    std::atomic<size_t> size_{0};  // 所有分片中条目的总字节数
+
+    ResponseCache() = default;
+
+    Shard& shard(const std::string& url);
+
+    // 将 body 完全解码到新条目的分配区中
+    static std::shared_ptr<Entry> make_entry(const std::string& url, const std::string& body);
+
+    // 移除 LRU 中的一项（调用者持有分片的锁）
+    void erase(Shard& shard, std::list<std::shared_ptr<Entry>>::iterator it);
+
+    // 总大小超过上限时，依次淘汰全局最久未使用的条目，直到不超过上限；keep 不被淘汰
+    // 调用者不持有任何分片的锁，每次只锁一个分片
+    void evict(const Entry* keep);
+
+public:
+    static ResponseCache& instance();
+
+    // 缓存的总大小上限（字节），0 表示关闭缓存
+    void set_capacity(size_t bytes) {
+        capacity_ = bytes;
+    }
+
+    // 查找未过期的值；返回的指针引用整个条目，持有期间条目即使被淘汰也不会释放
+    std::shared_ptr<const Value> lookup(const std::string& url);
+
+    // 解码 body 并缓存 ttl 时长，返回缓存的值；缓存关闭或解码后超过缓存的总上限时返回 nullptr
+    std::shared_ptr<const Value> store(const std::string& url, const std::string& body, std::chrono::seconds ttl);
+
+    // 与缓存的值一样完全解码到独立的分配区，但不放入缓存（合并的请求共享不可缓存的响应时使用）
+    static std::shared_ptr<const Value> decode(const std::string& body);
+};
+
+#endif // GLUE_CACHE_H
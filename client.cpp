@@ -0,0 +1,379 @@
+//
+// Created by ezzno on 2025/9/20.
+//
+
+#include <boost/beast.hpp>
+#include <boost/url.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include "client.h"
+
+namespace beast = boost::beast;         // from <boost/beast.hpp>
+namespace http = beast::http;           // from <boost/beast/http.hpp>
+namespace net = boost::asio;            // from <boost/asio.hpp>
+namespace urls = boost::urls;           // from <boost/url.hpp>
+using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// IMF-fixdate 格式的 HTTP 日期，如 "Sun, 06 Nov 1994 08:49:37 GMT"
+std::optional<std::chrono::system_clock::time_point> parse_http_date(const std::string& text) {
+    std::tm tm{};
+    std::istringstream in(text);
+    in >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+    if (in.fail()) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+
+// 响应的新鲜期：Cache-Control 的 s-maxage 优先于 max-age，都没有时为 Expires 与 Date 之差
+// 只缓存 200 响应；no-store、no-cache、private 的响应不缓存
+std::chrono::seconds freshness(const http::response<http::string_body>& res) {
+    using std::chrono::seconds;
+    if (res.result() != http::status::ok) {
+        return seconds(0);
+    }
+
+    std::string cache_control(res[http::field::cache_control]);
+    if (!cache_control.empty()) {
+        long max_age = -1;
+        long s_maxage = -1;
+        std::istringstream directives(cache_control);
+        for (std::string directive; std::getline(directives, directive, ',');) {
+            directive.erase(0, directive.find_first_not_of(" \t"));
+            directive.erase(directive.find_last_not_of(" \t") + 1);
+            std::transform(directive.begin(), directive.end(), directive.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+
+            if (directive == "no-store" || directive == "no-cache" || directive == "private") {
+                return seconds(0);
+            }
+            if (directive.rfind("s-maxage=", 0) == 0) {
+                s_maxage = std::strtol(directive.c_str() + std::strlen("s-maxage="), nullptr, 10);
+            } else if (directive.rfind("max-age=", 0) == 0) {
+                max_age = std::strtol(directive.c_str() + std::strlen("max-age="), nullptr, 10);
+            }
+        }
+        if (s_maxage >= 0 || max_age >= 0) {
+            return seconds(s_maxage >= 0 ? s_maxage : max_age);
+        }
+    }
+
+    std::string expires(res[http::field::expires]);
+    if (!expires.empty()) {
+        auto expires_at = parse_http_date(expires);
+        if (!expires_at) {
+            return seconds(0);  // 无效的日期（如 "0"）表示已过期
+        }
+        auto date = parse_http_date(std::string(res[http::field::date]));
+        auto now = date ? *date : std::chrono::system_clock::now();
+        return std::max(seconds(0), std::chrono::duration_cast<seconds>(*expires_at - now));
+    }
+
+    return seconds(0);
+}
+
+} // namespace
+
+struct HttpClient::Connection {
+    beast::tcp_stream stream;
+    beast::flat_buffer buffer;  // 读取响应的缓冲区，随连接复用
+    Clock::time_point idle_since;
+
+    explicit Connection(net::io_context& ioc) : stream(ioc) {}
+};
+
+// 一个 host:port 的连接池
+struct HttpClient::Pool {
+    std::string host;
+    std::string port;
+    tcp::resolver::results_type endpoints;          // 首次建立连接时解析，连接失败后重新解析
+    std::vector<std::unique_ptr<Connection>> idle;  // 按归还时间排序，最近归还的在末尾
+    size_t open = 0;                                // 已打开的连接数（含正在使用和正在建立的）
+    std::deque<std::shared_ptr<Request>> waiting;   // 等待连接的请求
+};
+
+// 一次 GET 请求：取得连接后发送请求、读取响应，完成后归还连接并调用回调
+struct HttpClient::Request : std::enable_shared_from_this<Request> {
+    HttpClient& client;
+    Pool& pool;
+    http::request<http::empty_body> req;
+    std::optional<http::response_parser<http::string_body>> parser;  // 每次读取响应前重新创建
+    std::unique_ptr<Connection> conn;
+    bool reused = false;  // 连接是否来自池中
+    Clock::time_point queued_at;  // 开始排队等待连接的时间
+    std::function<void(HttpResponse response)> callback;
+
+    Request(HttpClient& client, Pool& pool, std::function<void(HttpResponse response)> callback)
+        : client(client), pool(pool), callback(std::move(callback)) {}
+
+    void send(std::unique_ptr<Connection> connection, bool from_pool) {
+        conn = std::move(connection);
+        reused = from_pool;
+        conn->stream.expires_after(client.timeout());
+        http::async_write(conn->stream, req,
+            [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) {
+                    self->fail(ec);
+                    return;
+                }
+                self->receive();
+            });
+    }
+
+    void receive() {
+        // 响应体超过上限时读取失败（http::error::body_limit），连接关闭
+        parser.emplace();
+        parser->body_limit(client.max_body_.load());
+        conn->stream.expires_after(client.timeout());
+        http::async_read(conn->stream, conn->buffer, *parser,
+            [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) {
+                    self->fail(ec);
+                    return;
+                }
+                auto& res = self->parser->get();
+                bool keep_alive = res.keep_alive();
+                self->client.release(self->pool, std::move(self->conn), keep_alive);
+                auto max_age = freshness(res);
+                self->callback({std::move(res.body()), max_age});
+            });
+    }
+
+    // 失败的连接（超时时已被 tcp_stream 关闭）不放回池中
+    void fail(beast::error_code ec) {
+        if (conn) {
+            client.release(pool, std::move(conn), false);
+        }
+        // 池中的连接可能已被对端关闭，GET 可以安全地换一个连接重试
+        // 超时说明对端没有响应，响应体超过上限时换连接也一样，都不再重试
+        bool timed_out = ec == beast::error::timeout;
+        if (reused && !timed_out && ec != http::error::body_limit) {
+            client.acquire(shared_from_this());
+            return;
+        }
+        abort(ec.message(), timed_out);
+    }
+
+    void abort(const std::string& error, bool timed_out) {
+        std::cerr << "请求失败: " << error << std::endl;
+        HttpResponse response;
+        response.error = error;
+        response.timed_out = timed_out;
+        callback(std::move(response));
+    }
+};
+
+HttpClient::HttpClient() : work_(net::make_work_guard(ioc_)), thread_([this] { ioc_.run(); }) {}
+
+HttpClient::~HttpClient() {
+    work_.reset();
+    ioc_.stop();
+    thread_.join();
+}
+
+HttpClient& HttpClient::instance() {
+    static HttpClient client;
+    return client;
+}
+
+void HttpClient::configure(size_t max_connections, std::chrono::seconds idle_timeout, std::chrono::seconds timeout,
+                           uint64_t max_body) {
+    max_connections_ = std::max<size_t>(max_connections, 1);
+    idle_timeout_ = std::chrono::duration_cast<Clock::duration>(idle_timeout).count();
+    timeout_ = std::chrono::duration_cast<Clock::duration>(timeout).count();
+    max_body_ = max_body ? max_body : std::numeric_limits<uint64_t>::max();
+}
+
+void HttpClient::async_get(std::vector<std::string> urls, Callback callback) {
+    net::post(ioc_, [this, urls = std::move(urls), callback = std::move(callback)]() mutable {
+        // 各请求的回调都在 I/O 线程上执行，计数不需要同步
+        struct Batch {
+            std::vector<HttpResponse> responses;
+            size_t remaining;
+            Callback callback;
+        };
+        auto batch = std::make_shared<Batch>(Batch{std::vector<HttpResponse>(urls.size()), urls.size(),
+                                                   std::move(callback)});
+        if (urls.empty()) {
+            batch->callback({});
+            return;
+        }
+        for (size_t i = 0; i < urls.size(); ++i) {
+            start(urls[i], [batch, i](HttpResponse response) {
+                batch->responses[i] = std::move(response);
+                if (--batch->remaining == 0) {
+                    batch->callback(std::move(batch->responses));
+                }
+            });
+        }
+    });
+}
+
+std::vector<HttpResponse> HttpClient::get(std::vector<std::string> urls) {
+    std::promise<std::vector<HttpResponse>> promise;
+    auto responses = promise.get_future();
+    async_get(std::move(urls), [&promise](std::vector<HttpResponse> result) { promise.set_value(std::move(result)); });
+    return responses.get();
+}
+
+void HttpClient::start(const std::string& url, std::function<void(HttpResponse response)> done) {
+    std::string host, port, target;
+    try {
+        // 解析URL（提取主机、端口、路径等信息）
+        urls::url parsed_url(url);
+        if (!parsed_url.has_scheme()) {
+            throw std::invalid_argument("无效的URL格式：" + url);
+        }
+        host = parsed_url.host();
+        port = parsed_url.port().empty() ? "80" : std::string(parsed_url.port());  // HTTP默认端口
+        target = parsed_url.encoded_target().decode();
+    } catch (const std::exception& e) {
+        std::cerr << "请求失败: " << e.what() << std::endl;
+        HttpResponse response;
+        response.error = e.what();
+        done(std::move(response));
+        return;
+    }
+
+    auto& pool = pools_[host + ":" + port];
+    if (!pool) {
+        pool = std::make_unique<Pool>();
+        pool->host = host;
+        pool->port = port;
+    }
+
+    // HTTP/1.1 默认保持连接
+    auto request = std::make_shared<Request>(*this, *pool, std::move(done));
+    request->req = {http::verb::get, target.empty() ? "/" : target, 11};
+    request->req.set(http::field::host, host);
+    request->req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    acquire(request);
+}
+
+void HttpClient::acquire(const std::shared_ptr<Request>& request) {
+    Pool& pool = request->pool;
+
+    // 空闲过久的连接可能已被对端关闭，直接丢弃
+    auto deadline = Clock::now() - Clock::duration(idle_timeout_.load());
+    auto fresh = std::find_if(pool.idle.begin(), pool.idle.end(),
+                              [&](const auto& conn) { return conn->idle_since >= deadline; });
+    pool.open -= fresh - pool.idle.begin();
+    pool.idle.erase(pool.idle.begin(), fresh);
+
+    if (!pool.idle.empty()) {
+        auto conn = std::move(pool.idle.back());
+        pool.idle.pop_back();
+        request->send(std::move(conn), true);
+    } else if (pool.open < max_connections_) {
+        connect(request);
+    } else {
+        request->queued_at = Clock::now();
+        pool.waiting.push_back(request);
+    }
+}
+
+void HttpClient::connect(const std::shared_ptr<Request>& request) {
+    Pool& pool = request->pool;
+    ++pool.open;
+
+    auto on_error = [this, request](beast::error_code ec) {
+        Pool& pool = request->pool;
+        pool.endpoints = {};
+        --pool.open;
+        request->reused = false;
+        request->fail(ec);
+        // 空出的名额留给排队的请求
+        if (pool.open < max_connections_) {
+            if (auto next = next_waiting(pool)) {
+                connect(next);
+            }
+        }
+    };
+
+    auto on_resolved = [this, request, on_error](const tcp::resolver::results_type& endpoints) {
+        auto conn = std::make_unique<Connection>(ioc_);
+        auto& stream = conn->stream;
+        stream.expires_after(timeout());
+        stream.async_connect(endpoints,
+            [request, on_error, conn = std::move(conn)](beast::error_code ec, const tcp::endpoint&) mutable {
+                if (ec) {
+                    on_error(ec);
+                    return;
+                }
+                request->send(std::move(conn), false);
+            });
+    };
+
+    if (!pool.endpoints.empty()) {
+        on_resolved(pool.endpoints);
+        return;
+    }
+
+    // 域名解析也有超时：到期时取消解析
+    auto resolver = std::make_shared<tcp::resolver>(ioc_);
+    auto timer = std::make_shared<net::steady_timer>(ioc_, timeout());
+    timer->async_wait([resolver](beast::error_code ec) {
+        if (!ec) {
+            resolver->cancel();
+        }
+    });
+    resolver->async_resolve(pool.host, pool.port,
+        [resolver, timer, request, on_error, on_resolved](beast::error_code ec, tcp::resolver::results_type results) {
+            bool expired = timer->expiry() <= Clock::now();
+            timer->cancel();
+            if (ec) {
+                on_error(expired && ec == net::error::operation_aborted ? beast::error::timeout : ec);
+                return;
+            }
+            request->pool.endpoints = results;
+            on_resolved(results);
+        });
+}
+
+void HttpClient::release(Pool& pool, std::unique_ptr<Connection> conn, bool keep_alive) {
+    if (keep_alive) {
+        conn->idle_since = Clock::now();
+        if (auto next = next_waiting(pool)) {
+            next->send(std::move(conn), true);
+            return;
+        }
+        pool.idle.push_back(std::move(conn));
+        return;
+    }
+
+    // 忽略关闭时的错误，对端可能已经关闭连接
+    beast::error_code ec;
+    conn->stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+    conn.reset();
+    --pool.open;
+
+    if (auto next = next_waiting(pool)) {
+        connect(next);
+    }
+}
+
+std::shared_ptr<HttpClient::Request> HttpClient::next_waiting(Pool& pool) {
+    while (!pool.waiting.empty()) {
+        auto next = std::move(pool.waiting.front());
+        pool.waiting.pop_front();
+        if (Clock::now() - next->queued_at < timeout()) {
+            return next;
+        }
+        next->abort("timed out waiting for a connection", true);
+    }
+    return nullptr;
+}
@@ -0,0 +1,96 @@
+//
+// Created by ezzno on 2025/9/20.
+//
+
+#ifndef GLUE_CLIENT_H
+#define GLUE_CLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+// 响应体及按 Cache-Control / Expires 计算的新鲜期（不可缓存或请求失败时为 0）
+// 请求失败（无法连接、连接中断或超时）时 error 为失败原因，响应体为空
+struct HttpResponse {
+    std::string body;
+    std::chrono::seconds max_age{0};
+    std::string error;
+    bool timed_out = false;
+};
+
+// 出站 HTTP/1.1 客户端（<- 使用），进程内共享，线程安全
+// 所有连接都在客户端自己的 I/O 线程上异步收发，等待响应时不占用调用者的线程
+// 每个 host:port 维护一个长连接池：请求结束后连接放回池中复用，空闲超时的连接在下次取用时关闭
+// 同一主机同时打开的连接数有上限，达到上限时请求排队，等待其他请求归还连接
+// 域名解析、建立连接、发送请求和读取响应各有超时，超时的连接直接关闭，不放回池中
+// 排队超过超时时间的请求在有连接空出时以超时失败，因此每个请求都会在有限时间内完成
+class HttpClient {
+public:
+    // 各请求的响应（与地址顺序相同），失败的请求带有 error
+    using Callback = std::function<void(std::vector<HttpResponse> responses)>;
+
+private:
+    struct Connection;
+    struct Pool;
+    struct Request;
+
+    boost::asio::io_context ioc_;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_;
+    std::thread thread_;
+
+    // 只在 I/O 线程上访问，不需要加锁
+    std::unordered_map<std::string, std::unique_ptr<Pool>> pools_;  // 键为 host:port
+
+    std::atomic<size_t> max_connections_{16};
+    std::atomic<std::chrono::steady_clock::duration::rep> idle_timeout_{
+        std::chrono::steady_clock::duration(std::chrono::seconds(30)).count()};
+    std::atomic<std::chrono::steady_clock::duration::rep> timeout_{
+        std::chrono::steady_clock::duration(std::chrono::seconds(10)).count()};
+    std::atomic<uint64_t> max_body_{uint64_t(64) << 20};
+
+    HttpClient();
+
+    // 以下均在 I/O 线程上调用
+    void start(const std::string& url, std::function<void(HttpResponse response)> done);
+
+    // 为请求分配连接：优先复用空闲连接，其次新建，都不行时排队
+    void acquire(const std::shared_ptr<Request>& request);
+
+    void connect(const std::shared_ptr<Request>& request);
+
+    // 取出下一个排队的请求：排队超过超时时间的请求以超时失败，连接交给后面的请求
+    std::shared_ptr<Request> next_waiting(Pool& pool);
+
+    // 归还连接，keep_alive 为 false 时关闭；有排队的请求时直接交给它
+    void release(Pool& pool, std::unique_ptr<Connection> conn, bool keep_alive);
+
+    [[nodiscard]] std::chrono::steady_clock::duration timeout() const {
+        return std::chrono::steady_clock::duration(timeout_.load());
+    }
+
+public:
+    ~HttpClient();
+
+    static HttpClient& instance();
+
+    // 每个主机的最大连接数（至少为 1）、空闲连接的保留时间、建立连接、发送和读取的超时，
+    // 以及响应体的字节数上限（0 表示不限制，超过时请求失败）
+    void configure(size_t max_connections, std::chrono::seconds idle_timeout, std::chrono::seconds timeout,
+                   uint64_t max_body);
+
+    // 并发发送一组 GET 请求，全部完成后在客户端的 I/O 线程上调用 callback（不应在其中做耗时的工作）
+    void async_get(std::vector<std::string> urls, Callback callback);
+
+    // 阻塞等待一组 GET 请求全部完成，失败的请求输出错误并带有 error；不能在 callback 中调用
+    std::vector<HttpResponse> get(std::vector<std::string> urls);
+};
+
+#endif // GLUE_CLIENT_H
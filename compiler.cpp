@@ -0,0 +1,557 @@
+//
+// Created by ezzno on 2025/9/12.
+//
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "arena.h"
+#include "compiler.h"
+#include "router.h"
+
+int Compiler::emit(OpCode op, int a, int b) {
+    chunk_->code.push_back(Instruction{op, a, b});
+    return static_cast<int>(chunk_->code.size()) - 1;
+}
+
+void Compiler::patch(int at) {
+    chunk_->code[at].a = static_cast<int>(chunk_->code.size());
+}
+
+int Compiler::add_constant(Value value) {
+    chunk_->constants.push_back(std::move(value));
+    return static_cast<int>(chunk_->constants.size()) - 1;
+}
+
+int Compiler::add_name(const std::string& name) {
+    auto it = names_.find(name);
+    if (it != names_.end()) {
+        return it->second;
+    }
+    int index = add_constant(module_->strings->intern(name));
+    names_[name] = index;
+    return index;
+}
+
+void Compiler::declare_locals(const std::vector<std::string>& assigned) {
+    if (function_->global_scope) {
+        return;
+    }
+
+    for (const auto& name : assigned) {
+        if (!slots_.count(name)) {
+            slots_[name] = static_cast<int>(function_->slots.size());
+            function_->slots.push_back(name);
+        }
+    }
+
+    // 与全局变量同名的局部变量在赋值前读到的是全局变量：进入函数时先从全局变量复制
+    for (size_t slot = function_->parameters.size(); slot < function_->slots.size(); ++slot) {
+        if (globals_.count(function_->slots[slot])) {
+            emit(OpCode::LOAD_GLOBAL, add_name(function_->slots[slot]));
+            emit(OpCode::STORE_LOCAL, static_cast<int>(slot));
+            emit(OpCode::POP);
+        }
+    }
+}
+
+void Compiler::emit_load(const std::string& name) {
+    auto it = slots_.find(name);
+    if (it != slots_.end()) {
+        emit(OpCode::LOAD_LOCAL, it->second);
+    } else {
+        emit(OpCode::LOAD_GLOBAL, add_name(name));
+    }
+}
+
+void Compiler::emit_store(const std::string& name) {
+    auto it = slots_.find(name);
+    if (it != slots_.end()) {
+        emit(OpCode::STORE_LOCAL, it->second);
+    } else {
+        emit(OpCode::STORE_GLOBAL, add_name(name));
+    }
+}
+
+const Value& Compiler::literal(const ExprNode* expr) const {
+    if (expr->constant < 0 || static_cast<size_t>(expr->constant) >= literals_->size()) {
+        throw CompileError("Undecoded literal: " + expr->to_string());
+    }
+    return (*literals_)[expr->constant];
+}
+
+int Compiler::add_literal(const ExprNode* expr) {
+    auto it = literal_constants_.find(expr->constant);
+    if (it != literal_constants_.end()) {
+        return it->second;
+    }
+    int index = add_constant(literal(expr));
+    literal_constants_[expr->constant] = index;
+    return index;
+}
+
+std::unique_ptr<Function> Compiler::compile_function(const std::string& name, const Parameters& parameters,
+                                                     const std::vector<std::string>& assigned, const StmtNode* body,
+                                                     bool global_scope) {
+    auto func = std::make_unique<Function>();
+    func->name = name;
+    func->parameters = parameters;
+    func->global_scope = global_scope;
+
+    function_ = func.get();
+    chunk_ = &func->chunk;
+    names_.clear();
+    literal_constants_.clear();
+    slots_.clear();
+
+    // 参数占用前几个槽位，其后是函数体内赋值的变量
+    for (const auto& parameter : parameters) {
+        slots_[parameter] = static_cast<int>(func->slots.size());
+        func->slots.push_back(parameter);
+    }
+    declare_locals(assigned);
+
+    compile_statement(body);
+
+    // 函数末尾隐式返回空值
+    emit(OpCode::CONST, add_constant(NULL_VALUE));
+    emit(OpCode::RETURN);
+
+    function_ = nullptr;
+    chunk_ = nullptr;
+    return func;
+}
+
+void Compiler::compile_statement(const StmtNode* stmt) {
+    if (!stmt) {
+        return;
+    }
+
+    switch (stmt->stmt_type) {
+        case StmtNode::StmtType::EXPRESSION: {
+            if (stmt->expr) {
+                compile_expression(stmt->expr.get());
+                emit(OpCode::POP);
+            }
+            break;
+        }
+
+        case StmtNode::StmtType::BLOCK: {
+            const auto& children = stmt->children;
+            for (size_t i = 0; i < children.size();) {
+                size_t end = fan_out_end(children, i);
+                if (end > i) {
+                    compile_fan_out(children, i, end);
+                    i = end;
+                } else {
+                    compile_statement(children[i].get());
+                    ++i;
+                }
+            }
+            break;
+        }
+
+        case StmtNode::StmtType::IF: {
+            if (!stmt->condition) {
+                throw CompileError("If statement missing condition");
+            }
+
+            compile_expression(stmt->condition.get());
+            int jump_else = emit(OpCode::JUMP_IF_FALSE);
+            if (!stmt->children.empty()) {
+                compile_statement(stmt->children[0].get());
+            }
+
+            if (stmt->children.size() >= 2) {
+                int jump_end = emit(OpCode::JUMP);
+                patch(jump_else);
+                compile_statement(stmt->children[1].get());
+                patch(jump_end);
+            } else {
+                patch(jump_else);
+            }
+            break;
+        }
+
+        case StmtNode::StmtType::WHILE: {
+            if (!stmt->condition) {
+                throw CompileError("While statement missing condition");
+            }
+
+            int loop = static_cast<int>(chunk_->code.size());
+            compile_expression(stmt->condition.get());
+            int jump_end = emit(OpCode::JUMP_IF_FALSE, 0, 1);
+            if (!stmt->children.empty()) {
+                compile_statement(stmt->children[0].get());
+            }
+            emit(OpCode::JUMP, loop);
+            patch(jump_end);
+            break;
+        }
+
+        case StmtNode::StmtType::FOR: {
+            // children: 初始化、迭代、循环体
+            if (stmt->children.size() != 3) {
+                throw CompileError("Malformed for statement");
+            }
+
+            compile_statement(stmt->children[0].get());
+
+            int loop = static_cast<int>(chunk_->code.size());
+            int jump_end = -1;
+            if (stmt->condition) {
+                compile_expression(stmt->condition.get());
+                jump_end = emit(OpCode::JUMP_IF_FALSE, 0, 1);
+            }
+
+            compile_statement(stmt->children[2].get());
+            compile_statement(stmt->children[1].get());
+            emit(OpCode::JUMP, loop);
+
+            if (jump_end >= 0) {
+                patch(jump_end);
+            }
+            break;
+        }
+
+        case StmtNode::StmtType::EACH: {
+            const auto expr = stmt->expr.get();
+            if (!expr || expr->parameters.size() != 2 || stmt->children.empty()) {
+                throw CompileError("each expects exactly two parameters");
+            }
+
+            // 栈上保存迭代状态 [数组, i, j]
+            emit_load(expr->value);
+            emit(OpCode::CONST, add_constant(0));
+            emit(OpCode::CONST, add_constant(1));
+
+            // EACH 压入一组元素对，依次写入两个参数
+            int loop = emit(OpCode::EACH);
+            emit_store(expr->parameters[1]);
+            emit(OpCode::POP);
+            emit_store(expr->parameters[0]);
+            emit(OpCode::POP);
+            if (stmt->condition) {
+                compile_expression(stmt->condition.get());
+                emit(OpCode::JUMP_IF_FALSE, loop, 1);
+            }
+            compile_statement(stmt->children[0].get());
+            emit(OpCode::JUMP, loop);
+            patch(loop);
+            break;
+        }
+
+        case StmtNode::StmtType::RETURN: {
+            if (stmt->expr) {
+                compile_expression(stmt->expr.get());
+            } else {
+                emit(OpCode::CONST, add_constant(NULL_VALUE));
+            }
+            emit(OpCode::RETURN);
+            break;
+        }
+
+        case StmtNode::StmtType::PRINT: {
+            for (const auto& expr : stmt->exprs) {
+                compile_expression(expr.get());
+            }
+            emit(OpCode::PRINT, static_cast<int>(stmt->exprs.size()));
+            break;
+        }
+
+        case StmtNode::StmtType::DECLARATION: {
+            if (stmt->expr) {
+                compile_expression(stmt->expr.get());
+                emit(OpCode::POP);
+            }
+            break;
+        }
+
+        case StmtNode::StmtType::EMPTY:
+            // 空语句，什么都不做
+            break;
+
+        default:
+            throw CompileError("Unsupported statement: " + stmt->to_string());
+    }
+}
+
+// 语句 `x <- url;`，返回其中的 <- 表达式
+static const ExprNode* as_fetch(const StmtNode* stmt) {
+    if (stmt->stmt_type != StmtNode::StmtType::EXPRESSION || !stmt->expr) {
+        return nullptr;
+    }
+    const ExprNode* expr = stmt->expr.get();
+    if (expr->op_type != ExprNode::OpType::CURL || !expr->right || !expr->left ||
+        expr->left->op_type != ExprNode::OpType::IDENTIFIER) {
+        return nullptr;
+    }
+    return expr;
+}
+
+// 表达式或语句中出现的所有标识符（含字段名，宁可多算）
+static void collect_names(const ExprNode* expr, std::unordered_set<std::string>& names) {
+    if (!expr) {
+        return;
+    }
+    if (expr->op_type == ExprNode::OpType::IDENTIFIER) {
+        names.insert(expr->value);
+    }
+    collect_names(expr->left.get(), names);
+    collect_names(expr->right.get(), names);
+    for (const auto& elem : expr->array_elements) {
+        collect_names(elem.get(), names);
+    }
+    for (const auto& [key, value] : expr->object_members) {
+        collect_names(value.get(), names);
+    }
+}
+
+static void collect_names(const StmtNode* stmt, std::unordered_set<std::string>& names) {
+    collect_names(stmt->expr.get(), names);
+    collect_names(stmt->condition.get(), names);
+    for (const auto& expr : stmt->exprs) {
+        collect_names(expr.get(), names);
+    }
+    for (const auto& child : stmt->children) {
+        collect_names(child.get(), names);
+    }
+}
+
+size_t Compiler::fan_out_end(const std::vector<std::unique_ptr<StmtNode>>& stmts, size_t begin) const {
+    std::unordered_set<std::string> targets;
+    size_t fetches = 0;
+    size_t end = begin;
+
+    for (size_t i = begin; i < stmts.size(); ++i) {
+        const StmtNode* stmt = stmts[i].get();
+
+        // 读写已发出请求的目标变量的语句须等结果写入后执行
+        std::unordered_set<std::string> names;
+        collect_names(stmt, names);
+        if (std::any_of(names.begin(), names.end(), [&](const auto& name) { return targets.count(name); })) {
+            break;
+        }
+
+        // 结果写入局部变量槽位，全局变量（init 中）不参与
+        const ExprNode* fetch = as_fetch(stmt);
+        if (fetch && slots_.count(fetch->left->value)) {
+            targets.insert(fetch->left->value);
+            ++fetches;
+            end = i + 1;
+            continue;
+        }
+
+        // 夹在中间的只能是不含控制流的简单语句，保证到达 AWAIT 前不会离开当前函数
+        if (i == begin || (stmt->stmt_type != StmtNode::StmtType::EXPRESSION &&
+                           stmt->stmt_type != StmtNode::StmtType::DECLARATION &&
+                           stmt->stmt_type != StmtNode::StmtType::PRINT &&
+                           stmt->stmt_type != StmtNode::StmtType::EMPTY)) {
+            break;
+        }
+    }
+
+    return fetches >= 2 ? end : begin;
+}
+
+void Compiler::compile_fan_out(const std::vector<std::unique_ptr<StmtNode>>& stmts, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const ExprNode* fetch = as_fetch(stmts[i].get());
+        if (fetch && slots_.count(fetch->left->value)) {
+            compile_expression(fetch->right.get());
+            bool ttl = compile_ttl(fetch);
+            emit(OpCode::FETCH, slots_.at(fetch->left->value), ttl);
+        } else {
+            compile_statement(stmts[i].get());
+        }
+    }
+    emit(OpCode::AWAIT);
+}
+
+bool Compiler::compile_ttl(const ExprNode* curl) {
+    if (curl->array_elements.empty()) {
+        return false;
+    }
+    compile_expression(curl->array_elements[0].get());
+    return true;
+}
+
+void Compiler::compile_path(const ExprNode* node) {
+    while (node != nullptr) {
+        switch (node->op_type) {
+            case ExprNode::OpType::PARAMETERS: {
+                for (const auto& elem : node->array_elements) {
+                    compile_expression(elem.get());
+                }
+                emit(OpCode::CALL, static_cast<int>(node->array_elements.size()));
+                break;
+            }
+            case ExprNode::OpType::ARRAY_ACCESS: {
+                compile_expression(node->left.get());
+                emit(OpCode::INDEX);
+                break;
+            }
+            case ExprNode::OpType::DOT: {
+                if (node->token_type == CONSTANT_INTEGER) {
+                    emit(OpCode::ELEMENT, literal(node).as_int());
+                } else {
+                    emit(OpCode::FIELD, add_name(node->value));
+                }
+                break;
+            }
+            default:
+                throw CompileError("Unsupported access path: " + node->to_string());
+        }
+        node = node->right.get();
+    }
+}
+
+void Compiler::compile_expression(const ExprNode* expr) {
+    if (!expr) {
+        throw CompileError("Null expression");
+    }
+
+    switch (expr->op_type) {
+        case ExprNode::OpType::CONSTANT_INT:
+        case ExprNode::OpType::CONSTANT_FLOAT:
+        case ExprNode::OpType::CONSTANT_VALUE:
+            emit(OpCode::CONST, add_literal(expr));
+            break;
+
+        case ExprNode::OpType::CONSTANT_STRING:
+            // 与同名的变量、字段名共用常量
+            emit(OpCode::CONST, add_name(literal(expr).as_string()));
+            break;
+
+        case ExprNode::OpType::IDENTIFIER:
+            emit_load(expr->value);
+            compile_path(expr->right.get());
+            break;
+
+        case ExprNode::OpType::ADD:
+        case ExprNode::OpType::SUB:
+        case ExprNode::OpType::MUL:
+        case ExprNode::OpType::DIV:
+        case ExprNode::OpType::EQ:
+        case ExprNode::OpType::NEQ:
+        case ExprNode::OpType::LT:
+        case ExprNode::OpType::GT:
+        case ExprNode::OpType::LE:
+        case ExprNode::OpType::GE:
+        case ExprNode::OpType::AND:
+        case ExprNode::OpType::OR: {
+            compile_expression(expr->left.get());
+            compile_expression(expr->right.get());
+
+            static const std::unordered_map<ExprNode::OpType, OpCode> binary_ops = {
+                {ExprNode::OpType::ADD, OpCode::ADD}, {ExprNode::OpType::SUB, OpCode::SUB},
+                {ExprNode::OpType::MUL, OpCode::MUL}, {ExprNode::OpType::DIV, OpCode::DIV},
+                {ExprNode::OpType::EQ, OpCode::EQ}, {ExprNode::OpType::NEQ, OpCode::NEQ},
+                {ExprNode::OpType::LT, OpCode::LT}, {ExprNode::OpType::GT, OpCode::GT},
+                {ExprNode::OpType::LE, OpCode::LE}, {ExprNode::OpType::GE, OpCode::GE},
+                {ExprNode::OpType::AND, OpCode::AND}, {ExprNode::OpType::OR, OpCode::OR},
+            };
+            emit(binary_ops.at(expr->op_type));
+            break;
+        }
+
+        case ExprNode::OpType::NOT:
+            // 解析器把操作数放在 right
+            compile_expression(expr->right ? expr->right.get() : expr->left.get());
+            emit(OpCode::NOT);
+            break;
+
+        case ExprNode::OpType::ASSIGN: {
+            if (!expr->left || expr->left->op_type != ExprNode::OpType::IDENTIFIER) {
+                throw CompileError("Invalid assignment target");
+            }
+
+            compile_expression(expr->right.get());
+            emit_store(expr->left->value);
+            break;
+        }
+
+        case ExprNode::OpType::ARRAY_LITERAL: {
+            for (const auto& elem : expr->array_elements) {
+                compile_expression(elem.get());
+            }
+            emit(OpCode::ARRAY, static_cast<int>(expr->array_elements.size()));
+            break;
+        }
+
+        case ExprNode::OpType::ARRAY_ACCESS: {
+            if (!expr->left || !expr->right) {
+                throw CompileError("Invalid array access expression");
+            }
+
+            compile_expression(expr->left.get());
+            compile_expression(expr->right.get());
+            emit(OpCode::INDEX);
+            break;
+        }
+
+        case ExprNode::OpType::OBJECT_LITERAL: {
+            for (const auto& [key, value] : expr->object_members) {
+                emit(OpCode::CONST, add_name(key));
+                compile_expression(value.get());
+            }
+            emit(OpCode::OBJECT, static_cast<int>(expr->object_members.size()));
+            break;
+        }
+
+        case ExprNode::OpType::CURL: {
+            if (!expr->left || !expr->right) {
+                throw CompileError("Invalid curl expression");
+            }
+            if (expr->left->op_type != ExprNode::OpType::IDENTIFIER) {
+                throw CompileError("Invalid assignment target");
+            }
+
+            compile_expression(expr->right.get());
+            bool ttl = compile_ttl(expr);
+            emit(OpCode::CURL, 0, ttl);
+            emit_store(expr->left->value);
+            break;
+        }
+
+        default:
+            throw CompileError("Unsupported expression: " + expr->to_string());
+    }
+}
+
+std::shared_ptr<Module> Compiler::compile(const ProgramNode& program) {
+    auto module = std::make_shared<Module>();
+    if (program.strings) {
+        module->strings = program.strings;
+    }
+    module_ = module.get();
+    literals_ = &program.constants;
+
+    // 按名称排序，保证 --debug 输出稳定
+    std::vector<std::string> names;
+    for (const auto& [name, func] : program.functions) {
+        names.push_back(name);
+    }
+
+    // 全局变量只来自函数定义和 init 中的赋值
+    globals_.clear();
+    globals_.insert(names.begin(), names.end());
+    if (auto init = program.functions.find("init"); init != program.functions.end()) {
+        globals_.insert(init->second->assigned.begin(), init->second->assigned.end());
+    }
+    std::sort(names.begin(), names.end());
+
+    for (const auto& name : names) {
+        const auto& func = program.functions.at(name);
+        module->functions.push_back(compile_function(name, func->parameters, func->assigned, func->body.get(),
+                                                        name == "init"));
+    }
+
+    // 路径模板中的路径参数和查询参数是 api 的参数
+    for (const auto& api : program.apis) {
+        module->apis[api.get()] = compile_function(api->path, Router::parameters(api->path), api->assigned,
+                                                    api->body.get());
+    }
+
+    return module;
+}
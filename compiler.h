@@ -0,0 +1,93 @@
+//
+// Created by ezzno on 2025/9/12.
+//
+
+#ifndef GLUE_COMPILER_H
+#define GLUE_COMPILER_H
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bytecode.h"
+#include "parser.h"
+
+// 编译器：将AST降低为字节码
+class Compiler {
+private:
+    // 正在生成的模块与代码块
+    Module* module_ = nullptr;
+    Chunk* chunk_ = nullptr;
+
+    // 当前代码块中名称常量的下标（去重）
+    std::unordered_map<std::string, int> names_;
+
+    // 程序常量池，以及其中的字面量在当前代码块中的下标
+    const Values* literals_ = nullptr;
+    std::unordered_map<int, int> literal_constants_;
+
+    // 当前函数的局部变量槽位；init 中的变量都是全局变量
+    Function* function_ = nullptr;
+    std::unordered_map<std::string, int> slots_;
+
+    // 生成单个函数
+    std::unique_ptr<Function> compile_function(const std::string& name, const Parameters& parameters,
+                                               const std::vector<std::string>& assigned, const StmtNode* body,
+                                               bool global_scope = false);
+
+    // 语句生成
+    void compile_statement(const StmtNode* stmt);
+
+    // 表达式生成
+    void compile_expression(const ExprNode* expr);
+
+    // 并行发出的 <-：从 begin 开始、目标互不相同且地址不依赖彼此结果的一组 `x <- url;` 语句
+    // 返回最后一条 <- 之后的位置，不足两条时返回 begin
+    size_t fan_out_end(const std::vector<std::unique_ptr<StmtNode>>& stmts, size_t begin) const;
+    void compile_fan_out(const std::vector<std::unique_ptr<StmtNode>>& stmts, size_t begin, size_t end);
+
+    // <- 的缓存时长，有时压入栈顶并返回 true
+    bool compile_ttl(const ExprNode* curl);
+
+    // 标识符后的访问路径（.field / .1 / [expr] / (args)）
+    void compile_path(const ExprNode* node);
+
+    // 可能存在的全局变量：函数名与 init 中被赋值的名称
+    std::unordered_set<std::string> globals_;
+
+    // 函数体内被赋值的名称（解析时扫描）都是局部变量，与全局变量同名的在入口处以全局变量的值初始化
+    void declare_locals(const std::vector<std::string>& assigned);
+
+    // 读写变量：局部变量按槽位访问，其余按名称访问全局变量
+    void emit_load(const std::string& name);
+    void emit_store(const std::string& name);
+
+    // 辅助函数：追加一条指令，返回其下标
+    int emit(OpCode op, int a = 0, int b = 0);
+
+    // 辅助函数：回填跳转目标为当前位置
+    void patch(int at);
+
+    int add_constant(Value value);
+
+    int add_name(const std::string& name);
+
+    // 引用常量池中的字面量，同一代码块内只占一个常量
+    const Value& literal(const ExprNode* expr) const;
+    int add_literal(const ExprNode* expr);
+
+public:
+    // 编译整个程序
+    std::shared_ptr<Module> compile(const ProgramNode& program);
+};
+
+// 编译时异常
+class CompileError final : public std::runtime_error {
+public:
+    explicit CompileError(const std::string& message) : std::runtime_error(message) {}
+};
+
+#endif // GLUE_COMPILER_H
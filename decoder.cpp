@@ -0,0 +1,749 @@
+//
+// Created by ezzno on 2025/9/18.
+//
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define GLUE_DECODER_X86 1
+#endif
+
+#include "decoder.h"
+
+namespace {
+
+constexpr size_t BLOCK = 64;
+
+// 数组、对象的嵌套层数上限，超出时视为解析失败
+constexpr int MAX_DEPTH = 1024;
+
+// 一块 64 字节中各类字符的位图，第 i 位对应第 i 个字节
+struct Masks {
+    uint64_t quote = 0;
+    uint64_t backslash = 0;
+    uint64_t structural = 0;  // { } [ ] : ,
+    uint64_t whitespace = 0;
+    uint64_t control = 0;     // 小于 0x20 的字节，不能出现在字符串中
+};
+
+// ---------- 第一阶段：字符分类 ----------
+
+enum : uint8_t { QUOTE = 1, BACKSLASH = 2, STRUCTURAL = 4, WHITESPACE = 8, CONTROL = 16 };
+
+constexpr auto CLASSES = [] {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 0x20; ++c) {
+        table[c] = CONTROL;
+    }
+    table['"'] = QUOTE;
+    table['\\'] = BACKSLASH;
+    for (char c : {'{', '}', '[', ']', ':', ','}) {
+        table[static_cast<uint8_t>(c)] = STRUCTURAL;
+    }
+    for (char c : {' ', '\t', '\n', '\r'}) {
+        table[static_cast<uint8_t>(c)] |= WHITESPACE;
+    }
+    return table;
+}();
+
+Masks classify_scalar(const uint8_t* p) {
+    Masks m;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        uint8_t c = CLASSES[p[i]];
+        uint64_t bit = uint64_t{1} << i;
+        if (c & QUOTE) m.quote |= bit;
+        if (c & BACKSLASH) m.backslash |= bit;
+        if (c & STRUCTURAL) m.structural |= bit;
+        if (c & WHITESPACE) m.whitespace |= bit;
+        if (c & CONTROL) m.control |= bit;
+    }
+    return m;
+}
+
+#ifdef GLUE_DECODER_X86
+
+// SSE2 是 x86-64 的基础指令集，无需检测
+Masks classify_sse2(const uint8_t* p) {
+    auto eq = [](__m128i v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+    auto bits = [](__m128i v) { return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(v))); };
+
+    Masks m;
+    for (size_t i = 0; i < BLOCK; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i structural = _mm_or_si128(_mm_or_si128(_mm_or_si128(eq(v, '{'), eq(v, '}')),
+                                                       _mm_or_si128(eq(v, '['), eq(v, ']'))),
+                                          _mm_or_si128(eq(v, ':'), eq(v, ',')));
+        __m128i whitespace = _mm_or_si128(_mm_or_si128(eq(v, ' '), eq(v, '\t')),
+                                          _mm_or_si128(eq(v, '\n'), eq(v, '\r')));
+        __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f));
+
+        m.quote |= bits(eq(v, '"')) << i;
+        m.backslash |= bits(eq(v, '\\')) << i;
+        m.structural |= bits(structural) << i;
+        m.whitespace |= bits(whitespace) << i;
+        m.control |= bits(control) << i;
+    }
+    return m;
+}
+
+__attribute__((target("avx2")))
+inline __m256i eq(__m256i v, char c) {
+    return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+__attribute__((target("avx2")))
+inline uint64_t bits(__m256i v) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(v)));
+}
+
+// AVX2 需在运行时检测
+__attribute__((target("avx2")))
+Masks classify_avx2(const uint8_t* p) {
+    Masks m;
+    for (size_t i = 0; i < BLOCK; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i structural = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(eq(v, '{'), eq(v, '}')),
+                                                             _mm256_or_si256(eq(v, '['), eq(v, ']'))),
+                                             _mm256_or_si256(eq(v, ':'), eq(v, ',')));
+        __m256i whitespace = _mm256_or_si256(_mm256_or_si256(eq(v, ' '), eq(v, '\t')),
+                                             _mm256_or_si256(eq(v, '\n'), eq(v, '\r')));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1f)), _mm256_set1_epi8(0x1f));
+
+        m.quote |= bits(eq(v, '"')) << i;
+        m.backslash |= bits(eq(v, '\\')) << i;
+        m.structural |= bits(structural) << i;
+        m.whitespace |= bits(whitespace) << i;
+        m.control |= bits(control) << i;
+    }
+    return m;
+}
+
+#endif // GLUE_DECODER_X86
+
+using Classifier = Masks (*)(const uint8_t*);
+
+Classifier select_classifier() {
+#ifdef GLUE_DECODER_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return classify_avx2;
+    }
+    return classify_sse2;
+#else
+    return classify_scalar;
+#endif
+}
+
+// 当前使用的实现，可由 use_json_classifier 切换
+std::atomic<Classifier> active_classifier{select_classifier()};
+
+// 被反斜杠转义的字符：连续奇数个反斜杠之后的字符
+// prev_escaped 记录上一块末尾的反斜杠是否转义了本块的第一个字符
+uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped) {
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+    if (!backslash) {
+        uint64_t escaped = prev_escaped;
+        prev_escaped = 0;
+        return escaped;
+    }
+
+    // 被转义的反斜杠不再转义后面的字符
+    backslash &= ~prev_escaped;
+    uint64_t follows_escape = backslash << 1 | prev_escaped;
+
+    // 从奇数位开始的反斜杠序列，借助加法进位找到序列的末尾
+    uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+    unsigned long long sequences_starting_on_even_bits;
+    prev_escaped = __builtin_uaddll_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits);
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+
+    return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+// 前缀异或：第 i 位为 x 的第 0..i 位的异或，引号之间（含起始引号）为 1
+uint64_t prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// 构建结构索引：字符串外的结构字符、未转义的引号（起止各一个）、标量的第一个字符
+bool index_structurals(std::string_view text, std::vector<uint32_t>& indices) {
+    const Classifier classify = active_classifier.load(std::memory_order_relaxed);
+
+    indices.clear();
+    if (text.size() >= UINT32_MAX) {
+        return false;
+    }
+
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;  // 上一块结束时是否在字符串内（全 0 或全 1）
+    uint64_t prev_scalar = 0;     // 上一块的最后一个字节是否属于标量
+
+    const auto* data = reinterpret_cast<const uint8_t*>(text.data());
+    for (size_t base = 0; base < text.size(); base += BLOCK) {
+        // 最后不足一块的部分以空格补齐
+        uint8_t padded[BLOCK];
+        const uint8_t* block = data + base;
+        if (text.size() - base < BLOCK) {
+            std::memset(padded, ' ', BLOCK);
+            std::memcpy(padded, block, text.size() - base);
+            block = padded;
+        }
+
+        Masks m = classify(block);
+
+        uint64_t escaped = find_escaped(m.backslash, prev_escaped);
+        uint64_t quotes = m.quote & ~escaped;
+        uint64_t in_string = prefix_xor(quotes) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        if (m.control & in_string) {
+            return false;
+        }
+
+        uint64_t structural = m.structural & ~in_string;
+        uint64_t scalar = ~(m.structural | m.whitespace | m.quote) & ~in_string;
+        uint64_t scalar_start = scalar & ~(scalar << 1 | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        uint64_t bits = structural | quotes | scalar_start;
+        while (bits) {
+            indices.push_back(static_cast<uint32_t>(base + std::countr_zero(bits)));
+            bits &= bits - 1;
+        }
+    }
+
+    // 字符串未结束
+    return prev_in_string == 0;
+}
+
+// ---------- 第二阶段：校验与解码 ----------
+
+bool is_delimiter(char c) {
+    return CLASSES[static_cast<uint8_t>(c)] & (STRUCTURAL | WHITESPACE | QUOTE);
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+bool hex4(const char* p, uint32_t& out) {
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        out <<= 4;
+        if (c >= '0' && c <= '9') out |= c - '0';
+        else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+// 处理含反斜杠的字符串内容
+bool unescape(std::string_view in, std::string& out) {
+    out.reserve(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        char c = in[i];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i >= in.size()) {
+            return false;
+        }
+        switch (in[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (i + 4 >= in.size() || !hex4(in.data() + i + 1, cp)) {
+                    return false;
+                }
+                i += 4;
+                // 代理对
+                if (cp >= 0xd800 && cp <= 0xdbff) {
+                    uint32_t low;
+                    if (i + 6 >= in.size() || in[i + 1] != '\\' || in[i + 2] != 'u' ||
+                        !hex4(in.data() + i + 3, low) || low < 0xdc00 || low > 0xdfff) {
+                        return false;
+                    }
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+                    return false;
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool number(std::string_view token, Value& out) {
+    // 按 JSON 语法校验：-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    size_t i = 0;
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < token.size() && token[i] >= '0' && token[i] <= '9') {
+            ++i;
+        }
+        return i - start;
+    };
+
+    bool negative = i < token.size() && token[i] == '-';
+    if (negative) {
+        ++i;
+    }
+    size_t int_start = i;
+    size_t int_digits = digits();
+    if (int_digits == 0 || (int_digits > 1 && token[int_start] == '0')) {
+        return false;
+    }
+
+    bool integral = true;
+    if (i < token.size() && token[i] == '.') {
+        ++i;
+        if (digits() == 0) {
+            return false;
+        }
+        integral = false;
+    }
+    if (i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+        ++i;
+        if (i < token.size() && (token[i] == '+' || token[i] == '-')) {
+            ++i;
+        }
+        if (digits() == 0) {
+            return false;
+        }
+        integral = false;
+    }
+    if (i != token.size()) {
+        return false;
+    }
+
+    // 快速路径：不超过 18 位的整数不会溢出 int64；超出 int 范围的整数与小数一样转为 float
+    if (integral && int_digits <= 18) {
+        int64_t value = 0;
+        for (size_t k = int_start; k < token.size(); ++k) {
+            value = value * 10 + (token[k] - '0');
+        }
+        value = negative ? -value : value;
+        if (value >= INT32_MIN && value <= INT32_MAX) {
+            out = static_cast<int>(value);
+        } else {
+            out = static_cast<float>(static_cast<double>(value));
+        }
+        return true;
+    }
+
+    double value;
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (ec == std::errc::result_out_of_range) {
+        // 下溢为 0，上溢视为解析失败
+        value = std::strtod(std::string(token).c_str(), nullptr);
+        if (!std::isfinite(value)) {
+            return false;
+        }
+    } else if (ec != std::errc()) {
+        return false;
+    }
+    out = static_cast<float>(value);
+    return true;
+}
+
+// 从 begin 开始到下一个分隔符为止的标量记号
+std::string_view token_at(std::string_view text, size_t begin) {
+    size_t end = begin;
+    while (end < text.size() && !is_delimiter(text[end])) {
+        ++end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+bool scalar(std::string_view token, Value& out) {
+    switch (token[0]) {
+        case 't':
+            out = true;
+            return token == "true";
+        case 'f':
+            out = false;
+            return token == "false";
+        case 'n':
+            // null 映射为 int 0
+            out = NULL_VALUE;
+            return token == "null";
+        default:
+            return number(token, out);
+    }
+}
+
+} // namespace
+
+// 已建立结构索引的 JSON 文本，与解码出的值分配在同一个 arena 中
+struct JsonDocument {
+    std::string text;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> closes;  // 与 indices 等长：'{' '[' 处为匹配的 '}' ']' 在 indices 中的位置
+    Arena* arena = nullptr;
+};
+
+namespace {
+
+// 校验整个文档的语法（含标量和转义序列），同时记录括号的匹配位置
+class Validator {
+private:
+    std::string_view text_;
+    const std::vector<uint32_t>& indices_;
+    std::vector<uint32_t>& closes_;
+    size_t next_ = 0;  // 下一个待处理的索引
+
+    [[nodiscard]] bool at_end() const { return next_ >= indices_.size(); }
+    [[nodiscard]] char peek() const { return at_end() ? '\0' : text_[indices_[next_]]; }
+
+    bool expect(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        ++next_;
+        return true;
+    }
+
+    // 当前索引为起始引号，下一个索引必然是结束引号
+    bool string() {
+        if (peek() != '"' || next_ + 1 >= indices_.size()) {
+            return false;
+        }
+        size_t begin = indices_[next_] + 1;
+        size_t end = indices_[next_ + 1];
+        next_ += 2;
+        if (text_[end] != '"') {
+            return false;
+        }
+
+        std::string_view content = text_.substr(begin, end - begin);
+        if (std::memchr(content.data(), '\\', content.size()) == nullptr) {
+            return true;
+        }
+        std::string unescaped;
+        return unescape(content, unescaped);
+    }
+
+    // depth 为外层数组、对象的个数
+    bool value(int depth) {
+        switch (peek()) {
+            case '{': {
+                if (depth >= MAX_DEPTH) {
+                    return false;
+                }
+                size_t open = next_++;
+                if (!expect('}')) {
+                    do {
+                        if (!string() || !expect(':') || !value(depth + 1)) {
+                            return false;
+                        }
+                    } while (expect(','));
+                    if (!expect('}')) {
+                        return false;
+                    }
+                }
+                closes_[open] = static_cast<uint32_t>(next_ - 1);
+                return true;
+            }
+            case '[': {
+                if (depth >= MAX_DEPTH) {
+                    return false;
+                }
+                size_t open = next_++;
+                if (!expect(']')) {
+                    do {
+                        if (!value(depth + 1)) {
+                            return false;
+                        }
+                    } while (expect(','));
+                    if (!expect(']')) {
+                        return false;
+                    }
+                }
+                closes_[open] = static_cast<uint32_t>(next_ - 1);
+                return true;
+            }
+            case '"':
+                return string();
+            case '\0':
+            case '}':
+            case ']':
+            case ':':
+            case ',':
+                return false;
+            default: {
+                Value ignored;
+                return scalar(token_at(text_, indices_[next_++]), ignored);
+            }
+        }
+    }
+
+public:
+    explicit Validator(JsonDocument& doc) : text_(doc.text), indices_(doc.indices), closes_(doc.closes) {
+        closes_.assign(indices_.size(), 0);
+    }
+
+    // 整个文本恰好是一个值
+    bool document() {
+        return value(0) && at_end();
+    }
+};
+
+[[nodiscard]] char char_at(const JsonDocument& doc, size_t position) {
+    return doc.text[doc.indices[position]];
+}
+
+// position 处字符串的内容（文档已校验）
+std::string_view raw_string_at(const JsonDocument& doc, size_t position) {
+    size_t begin = doc.indices[position] + 1;
+    return std::string_view(doc.text).substr(begin, doc.indices[position + 1] - begin);
+}
+
+void string_at(const JsonDocument& doc, size_t position, std::string& out) {
+    std::string_view content = raw_string_at(doc, position);
+    if (std::memchr(content.data(), '\\', content.size()) == nullptr) {
+        out.assign(content);
+    } else {
+        unescape(content, out);
+    }
+}
+
+bool key_equals(const JsonDocument& doc, size_t position, const std::string& key) {
+    std::string_view content = raw_string_at(doc, position);
+    if (std::memchr(content.data(), '\\', content.size()) == nullptr) {
+        return content == key;
+    }
+    std::string unescaped;
+    unescape(content, unescaped);
+    return unescaped == key;
+}
+
+// position 处的值：标量与字符串直接解码，数组、对象为延迟值
+Value value_at(const JsonDocument& doc, size_t position) {
+    switch (char_at(doc, position)) {
+        case '{':
+        case '[':
+            return Value::lazy(doc.arena->make<LazyValue>(LazyValue{&doc, static_cast<uint32_t>(position)}));
+        case '"': {
+            std::string s;
+            string_at(doc, position, s);
+            return doc.arena->make_string(std::move(s));
+        }
+        default: {
+            Value out;
+            scalar(token_at(doc.text, doc.indices[position]), out);
+            return out;
+        }
+    }
+}
+
+// position 处的值之后的下一个位置
+size_t skip(const JsonDocument& doc, size_t position) {
+    switch (char_at(doc, position)) {
+        case '{':
+        case '[':
+            return doc.closes[position] + 1;
+        case '"':
+            return position + 2;
+        default:
+            return position + 1;
+    }
+}
+
+// 依次访问 position 处数组的元素位置，f 返回 false 时停止
+template<typename F>
+void for_each_element(const JsonDocument& doc, size_t position, F f) {
+    size_t p = position + 1;
+    if (char_at(doc, p) == ']') {
+        return;
+    }
+    while (f(p)) {
+        p = skip(doc, p);
+        if (char_at(doc, p) != ',') {
+            return;
+        }
+        ++p;
+    }
+}
+
+// 依次访问 position 处对象的成员（键的位置，值的位置）
+template<typename F>
+void for_each_member(const JsonDocument& doc, size_t position, F f) {
+    size_t p = position + 1;
+    if (char_at(doc, p) == '}') {
+        return;
+    }
+    while (true) {
+        f(p, p + 3);  // 键、':'、值
+        p = skip(doc, p + 3);
+        if (char_at(doc, p) != ',') {
+            return;
+        }
+        ++p;
+    }
+}
+
+// 已解码或被多次访问的节点按解码后的容器查找
+bool use_decoded(const LazyValue& lazy) {
+    return !lazy.decoded.is_int() || ++lazy.accesses > 1;
+}
+
+} // namespace
+
+Value parse_json(std::string text, Arena& arena) {
+    auto* doc = arena.make<JsonDocument>();
+    doc->text = std::move(text);
+    doc->arena = &arena;
+
+    if (!index_structurals(doc->text, doc->indices) || !Validator(*doc).document()) {
+        return NULL_VALUE;
+    }
+    return value_at(*doc, 0);
+}
+
+bool use_json_classifier(JsonClassifier classifier) {
+    Classifier selected = nullptr;
+    switch (classifier) {
+        case JsonClassifier::AUTO:
+            selected = select_classifier();
+            break;
+        case JsonClassifier::SCALAR:
+            selected = classify_scalar;
+            break;
+#ifdef GLUE_DECODER_X86
+        case JsonClassifier::SSE2:
+            selected = classify_sse2;
+            break;
+        case JsonClassifier::AVX2:
+            selected = __builtin_cpu_supports("avx2") ? classify_avx2 : nullptr;
+            break;
+#endif
+        default:
+            break;
+    }
+    if (!selected) {
+        return false;
+    }
+    active_classifier.store(selected, std::memory_order_relaxed);
+    return true;
+}
+
+Value materialize(const LazyValue& lazy) {
+    if (!lazy.decoded.is_int()) {
+        return lazy.decoded;
+    }
+
+    const JsonDocument& doc = *lazy.document;
+    if (char_at(doc, lazy.position) == '[') {
+        Values* array = doc.arena->new_array();
+        for_each_element(doc, lazy.position, [&](size_t p) {
+            array->push_back(value_at(doc, p));
+            return true;
+        });
+        lazy.decoded = Value::array(array);
+    } else {
+        // 键直接构造在 arena 中，移入哈希节点时不再复制
+        ValueMap* object = doc.arena->new_object();
+        std::string key;
+        for_each_member(doc, lazy.position, [&](size_t k, size_t v) {
+            string_at(doc, k, key);
+            object->insert_or_assign(std::pmr::string(key, doc.arena->resource()), value_at(doc, v));
+        });
+        lazy.decoded = Value::object(object);
+    }
+    return lazy.decoded;
+}
+
+bool lazy_field(const LazyValue& lazy, const std::string& key, Value& out) {
+    const JsonDocument& doc = *lazy.document;
+    if (char_at(doc, lazy.position) != '{') {
+        return false;
+    }
+
+    if (use_decoded(lazy)) {
+        const auto& object = materialize(lazy).as_object();
+        auto field = object.find(key);
+        out = field == object.end() ? Value(NULL_VALUE) : field->second;
+        return true;
+    }
+
+    // 重复的键以最后一个为准
+    size_t found = 0;
+    for_each_member(doc, lazy.position, [&](size_t k, size_t v) {
+        if (key_equals(doc, k, key)) {
+            found = v;
+        }
+    });
+    out = found ? value_at(doc, found) : Value(NULL_VALUE);
+    return true;
+}
+
+bool lazy_element(const LazyValue& lazy, size_t index, Value& out, size_t& size) {
+    const JsonDocument& doc = *lazy.document;
+    if (char_at(doc, lazy.position) != '[') {
+        return false;
+    }
+
+    if (use_decoded(lazy)) {
+        const auto& array = materialize(lazy).as_array();
+        size = array.size();
+        if (index < size) {
+            out = array[index];
+        }
+        return true;
+    }
+
+    size = 0;
+    for_each_element(doc, lazy.position, [&](size_t p) {
+        if (size++ == index) {
+            out = value_at(doc, p);
+            return false;
+        }
+        return true;
+    });
+    return true;
+}
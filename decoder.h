@@ -0,0 +1,35 @@
+//
+// Created by ezzno on 2025/9/18.
+//
+
+#ifndef GLUE_DECODER_H
+#define GLUE_DECODER_H
+
+#include <string>
+
+#include "arena.h"
+#include "value.h"
+
+// JSON 解码（<- 的响应体），分两个阶段：
+// 1. 以 64 字节为一块，用 SIMD（AVX2 / SSE2，运行时选择，其他平台为标量实现）
+//    找出字符串外的结构字符、未转义的引号和标量（数字、true/false/null）的起始位置
+// 2. 按索引校验整个文档，记录括号的匹配位置；数组、对象不立即解码，而是返回延迟值
+// 延迟值按路径访问时直接在索引上查找，只解码被取到的子树；同一节点第二次被访问
+// （或被遍历、序列化）时解码一层并缓存。text 和解码出的值都归 arena 所有
+// 超出 int 范围的整数解码为 float；数组、对象嵌套超过 1024 层时视为解析失败
+// 解析失败时为空值；不校验字符串中的 UTF-8 编码
+Value parse_json(std::string text, Arena& arena);
+
+// 第一阶段的字符分类实现：默认（AUTO）按 CPU 选择 AVX2、SSE2，其他平台为标量实现
+// 切换到指定实现后对之后的 parse_json 生效，用于比较各实现的结果（ro-bench check）；CPU 不支持时返回 false
+enum class JsonClassifier { AUTO, SCALAR, SSE2, AVX2 };
+bool use_json_classifier(JsonClassifier classifier);
+
+// 延迟值上的路径访问，类型不符（对数组取字段、对对象取下标）时返回 false
+// 对象中没有 key 时 out 为空值；重复的键以最后一个为准
+bool lazy_field(const LazyValue& lazy, const std::string& key, Value& out);
+
+// index 越界时不修改 out；size 为数组长度，找到元素时可能只数到 index + 1
+bool lazy_element(const LazyValue& lazy, size_t index, Value& out, size_t& size);
+
+#endif // GLUE_DECODER_H
@@ -0,0 +1,28 @@
+//
+// Created by ezzno on 2025/9/26.
+//
+
+#include "arena.h"
+#include "compiler.h"
+#include "executor.h"
+#include "lexer.h"
+#include "main.h"
+#include "optimizer.h"
+#include "parser.h"
+
+// eval 模式的一次求值（server.cpp 中处理 POST 请求体），与 main 分开，便于 ro-bench 链接
+std::string eval(const std::string& input) {
+    try {
+        Lexer lexer(input, true);
+        Parser parser(lexer);
+        std::unique_ptr<ProgramNode> program = parser.parse_program();
+        Arena arena;
+        Optimizer().run(*program, arena);
+        auto module = Compiler().compile(*program);
+        Executor executor(true, arena);
+        executor.execute(program, module);
+        return executor.result();
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+}
@@ -1,743 +1,747 @@
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
 #include <boost/url.hpp>
+#include <algorithm>
 #include <iostream>
+#include <thread>
+#include <utility>
 
 #include "json.hpp"
+#include "bytecode.h"
+#include "cache.h"
+#include "decoder.h"
 #include "executor.h"
+#include "jit.h"
+#include "singleflight.h"
 
 #include "main.h"
 #include "parser.h"
 #include "server.h"
 
-namespace urls = boost::urls; // 从<boost/url.hpp>
 using json = nlohmann::json;  // 简化类型名
 
-// 发送 HTTP GET 请求
-std::string http_get(const std::string& url) {
-    try {
-        // 1. 解析URL（提取主机、端口、路径等信息）
-        urls::url parsed_url(url);
-        if (!parsed_url.has_scheme()) {
-            throw std::invalid_argument("无效的URL格式：" + url);
-        }
-
-        // 提取URL中的关键信息
-        std::string host = parsed_url.host();                  // 主机名（如localhost）
-        std::string target = parsed_url.encoded_target().decode();      // 路径（如/hello）
-        unsigned short port; // 端口（如8015）
-        if (!parsed_url.port().empty()) {
-            port = std::stoi(parsed_url.port());
-        }
-        if (port == 0) { // 如果URL未指定端口，使用默认端口（HTTP默认80）
-            port = 80;  // HTTP默认端口
-        }
-
-        // 2. 初始化Boost.Asio的IO上下文（事件循环）
-        net::io_context ioc;
-
-        // 3. 解析域名获取服务器地址
-        tcp::resolver resolver(ioc);
-        auto const results = resolver.resolve(host, std::to_string(port));
-
-        // 4. 建立TCP连接
-        beast::tcp_stream stream(ioc);
-        stream.connect(results);
-
-        // 5. 构造HTTP GET请求
-        http::request<http::string_body> req{http::verb::get, target, 11};  // HTTP/1.1
-        req.set(http::field::host, host);                                   // 设置Host头（必须）
-        req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);       // 设置User-Agent
-
-        // 6. 发送请求到服务器
-        http::write(stream, req);
-
-        // 7. 接收服务器响应
-        beast::flat_buffer buffer;                // 用于存储响应数据的缓冲区
-        http::response<http::string_body> res;    // 用于存储响应的对象
-        http::read(stream, buffer, res); // 读取响应
-
-        // 8. 优雅关闭连接（忽略"未连接"的错误，因为可能服务器已主动关闭）
-        beast::error_code ec;
-        stream.socket().shutdown(tcp::socket::shutdown_both, ec);
-        if (ec && ec != beast::errc::not_connected) {
-            throw beast::system_error{ec};
-        }
-
-        // 9. 返回响应体（服务器返回的数据）
-        return res.body();
-
-    } catch (const std::exception& e) {
-        // 捕获并输出所有错误（如连接失败、URL无效等）
-        std::cerr << "请求失败: " << e.what() << std::endl;
-        return "";
-    }
-}
-
 // 辅助函数：获取值的类型名称
 static std::string get_type_name(const Value& val) {
-    if (std::holds_alternative<int>(val)) return "int";
-    if (std::holds_alternative<float>(val)) return "float";
-    if (std::holds_alternative<std::string>(val)) return "string";
-    if (std::holds_alternative<bool>(val)) return "bool";
-    return "unknown";
-}
-
-// 辅助函数：检查值是否为指定类型
-template<typename T>
-static bool is_type(const Value& val) {
-    return std::holds_alternative<T>(val);
-}
-
-// 辅助函数：安全地获取指定类型的值
-template<typename T>
-static const T& get_value(const Value& val) {
-    if (!is_type<T>(val)) {
-        throw ExecutionError("Type mismatch: expected " + std::string(typeid(T).name()) +
-                            ", got " + get_type_name(val));
+    switch (val.type()) {
+        case Value::Type::INT: return "int";
+        case Value::Type::FLOAT: return "float";
+        case Value::Type::STRING: return "string";
+        case Value::Type::BOOL: return "bool";
+        default: return "unknown";
     }
-    return std::get<T>(val);
 }
 
-// 辅助函数：获取数组元素
-static std::vector<Value>& cast_to_array(const Value& array_val) {
-    if (!is_type<ComplexValue>(array_val)) {
+// 辅助函数：获取数组
+// 数组、对象创建后不再修改，读取时直接引用原容器，不做拷贝；延迟值在遍历前解码一层
+static const Values& cast_to_array(const Value& array_val) {
+    Value array = array_val.is_lazy() ? materialize(array_val.as_lazy()) : array_val;
+    if (!array.is_array()) {
         throw ExecutionError("Array access on non-array type");
     }
-
-    ComplexValue val_ptr = get_value<ComplexValue>(array_val);
-    if (val_ptr.first != 1) {
-        throw ExecutionError("Array access on non-array type");
-    }
-
-    return *static_cast<std::vector<Value>*>(val_ptr.second);  // 返回引用
+    return array.as_array();  // 返回引用
 }
 
-Value Executor::evaluate_address_index(const ExprNode* expr) {
-    if (!expr) {
-        throw ExecutionError("Null expression");
-    }
-
-    switch (expr->op_type) {
-        case ExprNode::OpType::CONSTANT_INT:
-            return std::stoi(expr->value);
-
-        case ExprNode::OpType::IDENTIFIER: {
-            return expr->value;
-        }
-        default: ;
-    }
-
-    throw ExecutionError("unexpected op type in address index");
+static void throw_out_of_bounds(size_t index, size_t size) {
+    throw ExecutionError("Array index out of bounds: " + std::to_string(index) +
+                        " (array size: " + std::to_string(size) + ")");
 }
 
 // 辅助函数：获取数组元素
 static Value get_array_element(const Value& array_val, size_t index) {
-    if (!is_type<ComplexValue>(array_val)) {
-        throw ExecutionError("Array access on non-array type");
-    }
-
-    ComplexValue val_ptr = get_value<ComplexValue>(array_val);
-    if (val_ptr.first != 1) {
-        throw ExecutionError("Array access on non-array type");
+    if (array_val.is_lazy()) {
+        Value element;
+        size_t size = 0;
+        if (!lazy_element(array_val.as_lazy(), index, element, size)) {
+            throw ExecutionError("Array access on non-array type");
+        }
+        if (index >= size) {
+            throw_out_of_bounds(index, size);
+        }
+        return element;
     }
 
-    auto array = *static_cast<Values*>(val_ptr.second);
+    const auto& array = cast_to_array(array_val);
 
     if (index >= array.size()) {
-        throw ExecutionError("Array index out of bounds: " + std::to_string(index) +
-                            " (array size: " + std::to_string(array.size()) + ")");
+        throw_out_of_bounds(index, array.size());
     }
 
     return array[index];
 }
 
-static Value get_object_field(const Value& object_val, std::string index) {
-    if (!is_type<ComplexValue>(object_val)) {
-        throw ExecutionError("Field access on non-object type");
+// 辅助函数：获取对象字段，不存在时为空值（不向共享的对象中插入）
+static Value get_object_field(const Value& object_val, const std::string& index) {
+    if (object_val.is_lazy()) {
+        Value field;
+        if (!lazy_field(object_val.as_lazy(), index, field)) {
+            throw ExecutionError("Field access on non-object type");
+        }
+        return field;
     }
 
-    ComplexValue val_ptr = get_value<ComplexValue>(object_val);
-    if (val_ptr.first != 2) {
+    if (!object_val.is_object()) {
         throw ExecutionError("Field access on non-object type");
     }
 
-    auto obj = *static_cast<ValueMap*>(val_ptr.second);
+    const auto& obj = object_val.as_object();
+    auto field = obj.find(index);
+    if (field == obj.end()) {
+        return NULL_VALUE;
+    }
 
-    return obj[index];
+    return field->second;
 }
 
-static FuncNode* as_function(const Value& object_val) {
-    if (!is_type<ComplexValue>(object_val)) {
-        throw ExecutionError("not a function");
-    }
-
-    auto val_ptr = get_value<ComplexValue>(object_val);
-    if (val_ptr.first != 3) {
+static const Function* as_function(const Value& object_val) {
+    if (!object_val.is_function()) {
         throw ExecutionError("not a function");
     }
 
-    return static_cast<FuncNode*>(val_ptr.second);
+    return object_val.as_function();
 }
 
 std::string Executor::value_to_string(const Value& val) const {
-    if (std::holds_alternative<int>(val)) {
-        return std::to_string(std::get<int>(val));
-    } else if (std::holds_alternative<float>(val)) {
-        return std::to_string(std::get<float>(val));
-    } else if (std::holds_alternative<std::string>(val)) {
-        return std::get<std::string>(val);
-    } else if (std::holds_alternative<bool>(val)) {
-        return std::get<bool>(val) ? "true" : "false";
-    }
-    return "unknown";
-}
-
-Value Executor::evaluate_expression(const ExprNode* expr) {
-    if (!expr) {
-        throw ExecutionError("Null expression");
+    switch (val.type()) {
+        case Value::Type::INT: return std::to_string(val.as_int());
+        case Value::Type::FLOAT: return std::to_string(val.as_float());
+        case Value::Type::STRING: return val.as_string();
+        case Value::Type::BOOL: return val.as_bool() ? "true" : "false";
+        default: return "unknown";
     }
+}
 
-    switch (expr->op_type) {
-        case ExprNode::OpType::CONSTANT_INT:
-            return std::stoi(expr->value);
-
-        case ExprNode::OpType::CONSTANT_FLOAT:
-            return std::stof(expr->value);
-
-        case ExprNode::OpType::CONSTANT_STRING:
-            return expr->value;
-
-        case ExprNode::OpType::IDENTIFIER: {
-            auto it = variables.find(expr->value);
-            if (it == variables.end()) {
-                // todo: reference ??
-                return 0;
-                //return 0;
-                throw ExecutionError("Undefined variable: " + expr->value);
-            }
-            auto val = it->second;
-
-            auto node = expr->right ? expr->right.get() : nullptr;
-            while (node != nullptr) {
-                if (node->op_type == ExprNode::OpType::PARAMETERS) {
-                    auto params = std::vector<Value>();
-                    for (const auto& elem_node : expr->array_elements) {
-                        params.push_back(evaluate_expression(elem_node.get()));
-                    }
-                    val = execute_function(as_function(val), params);
-                }
-                else if (node->token_type == CONSTANT_INTEGER) {
-                    int index = std::stoi(node->value);
-                    if (index < 0) {
-                        return NULL_VALUE;
-                    }
-                    val = get_array_element(val, static_cast<size_t>(index));
-                }
-                else {
-                    val = get_object_field(val, node->value);
-                }
-                node = node->right.get();
-            }
-            return val;
-        }
-
-        case ExprNode::OpType::ADD: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) + get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l + r;
-            } else if (is_type<std::string>(left_val) && is_type<std::string>(right_val)) {
-                return get_value<std::string>(left_val) + get_value<std::string>(right_val);
-            }
-
-            throw ExecutionError("Addition not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
-
-        case ExprNode::OpType::SUB: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) - get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l - r;
-            }
-
-            throw ExecutionError("Subtraction not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
-
-        case ExprNode::OpType::MUL: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) * get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l * r;
-            }
-
-            throw ExecutionError("Multiplication not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+// 辅助函数：int 或 float 转为 float
+static float as_number(const Value& val) {
+    return val.is_int() ? static_cast<float>(val.as_int()) : val.as_float();
+}
 
-        case ExprNode::OpType::DIV: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
+static bool is_number(const Value& val) {
+    return val.is_int() || val.is_float();
+}
 
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                int r = get_value<int>(right_val);
+// 辅助函数：算术运算
+Value arithmetic(OpCode op, const Value& left_val, const Value& right_val, Arena& arena) {
+    if (left_val.is_int() && right_val.is_int()) {
+        int l = left_val.as_int();
+        int r = right_val.as_int();
+        switch (op) {
+            case OpCode::ADD: return l + r;
+            case OpCode::SUB: return l - r;
+            case OpCode::MUL: return l * r;
+            default:
                 if (r == 0) throw ExecutionError("Division by zero");
-                return get_value<int>(left_val) / r;
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
+                return l / r;
+        }
+    } else if (is_number(left_val) && is_number(right_val)) {
+        float l = as_number(left_val);
+        float r = as_number(right_val);
+        switch (op) {
+            case OpCode::ADD: return l + r;
+            case OpCode::SUB: return l - r;
+            case OpCode::MUL: return l * r;
+            default:
                 if (r == 0.0f) throw ExecutionError("Division by zero");
                 return l / r;
-            }
-
-            throw ExecutionError("Division not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
         }
+    } else if (op == OpCode::ADD && left_val.is_string() && right_val.is_string()) {
+        return arena.make_string(left_val.as_string() + right_val.as_string());
+    }
 
-        case ExprNode::OpType::EQ: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-            return left_val == right_val;
-        }
+    const char* name = op == OpCode::ADD ? "Addition" :
+                       op == OpCode::SUB ? "Subtraction" :
+                       op == OpCode::MUL ? "Multiplication" : "Division";
+    throw ExecutionError(std::string(name) + " not supported for types: " +
+                         get_type_name(left_val) + " and " + get_type_name(right_val));
+}
 
-        case ExprNode::OpType::NEQ: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-            return left_val != right_val;
-        }
+// 辅助函数：比较运算
+template<typename T>
+static bool compare(OpCode op, const T& l, const T& r) {
+    switch (op) {
+        case OpCode::LT: return l < r;
+        case OpCode::GT: return l > r;
+        case OpCode::LE: return l <= r;
+        default: return l >= r;
+    }
+}
 
-        case ExprNode::OpType::LT: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) < get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l < r;
-            } else if (is_type<std::string>(left_val) && is_type<std::string>(right_val)) {
-                return get_value<std::string>(left_val) < get_value<std::string>(right_val);
-            }
+Value compare(OpCode op, const Value& left_val, const Value& right_val) {
+    if (left_val.is_int() && right_val.is_int()) {
+        return compare(op, left_val.as_int(), right_val.as_int());
+    } else if (is_number(left_val) && is_number(right_val)) {
+        return compare(op, as_number(left_val), as_number(right_val));
+    } else if (left_val.is_string() && right_val.is_string()) {
+        return compare(op, left_val.as_string(), right_val.as_string());
+    }
 
-            throw ExecutionError("Less than comparison not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+    const char* name = op == OpCode::LT ? "Less than" :
+                       op == OpCode::GT ? "Greater than" :
+                       op == OpCode::LE ? "Less than or equal" : "Greater than or equal";
+    throw ExecutionError(std::string(name) + " comparison not supported for types: " +
+                         get_type_name(left_val) + " and " + get_type_name(right_val));
+}
 
-        case ExprNode::OpType::GT: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) > get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l > r;
-            } else if (is_type<std::string>(left_val) && is_type<std::string>(right_val)) {
-                return get_value<std::string>(left_val) > get_value<std::string>(right_val);
-            }
+void Executor::push_frame(const Function* func, size_t base, size_t result_slot) {
+    // 多余的实参丢弃，缺少的参数与局部变量初始化为空值
+    stack_.resize(base + func->parameters.size());
+    stack_.resize(base + func->slots.size());
+    frames_.push_back(Frame{func, func->chunk.code.data(), base, result_slot});
+}
 
-            throw ExecutionError("Greater than comparison not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+bool Executor::local_route(const std::string& url, Router::Match& match) const {
+    if (routes_->empty()) {
+        return false;
+    }
 
-        case ExprNode::OpType::LE: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) <= get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l <= r;
-            } else if (is_type<std::string>(left_val) && is_type<std::string>(right_val)) {
-                return get_value<std::string>(left_val) <= get_value<std::string>(right_val);
-            }
+    auto parsed = boost::urls::parse_uri(url);
+    if (!parsed || parsed->scheme_id() != boost::urls::scheme::http) {
+        return false;
+    }
 
-            throw ExecutionError("Less than or equal comparison not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+    // 监听地址为 0.0.0.0，本机的这些地址都会连到自己
+    auto host = parsed->encoded_host();
+    if (host != "localhost" && host != "127.0.0.1" && host != "0.0.0.0" && host != "[::1]") {
+        return false;
+    }
 
-        case ExprNode::OpType::GE: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
-
-            if (is_type<int>(left_val) && is_type<int>(right_val)) {
-                return get_value<int>(left_val) >= get_value<int>(right_val);
-            } else if (is_type<float>(left_val) || is_type<float>(right_val)) {
-                float l = is_type<int>(left_val) ? get_value<int>(left_val) : get_value<float>(left_val);
-                float r = is_type<int>(right_val) ? get_value<int>(right_val) : get_value<float>(right_val);
-                return l >= r;
-            } else if (is_type<std::string>(left_val) && is_type<std::string>(right_val)) {
-                return get_value<std::string>(left_val) >= get_value<std::string>(right_val);
-            }
+    // 与 Session 一样按路径和查询串匹配
+    int port = parsed->has_port() ? parsed->port_number() : 80;
+    auto router = routes_->find(port);
+    if (router == routes_->end()) {
+        return false;
+    }
+    std::string_view path = parsed->encoded_path().empty() ? std::string_view("/") : std::string_view(parsed->encoded_path());
+    return router->second.match(path, parsed->encoded_query(), match);
+}
 
-            throw ExecutionError("Greater than or equal comparison not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+void Executor::push_arguments(const Router::Match& match) {
+    for (size_t i = 0; i < match.arguments.size(); ++i) {
+        const auto& argument = match.arguments[i];
+        stack_.push_back(argument ? arena_->make_string(Router::decode(*argument, i >= match.path_arguments)) : NULL_VALUE);
+    }
+}
 
-        case ExprNode::OpType::AND: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
+Value Executor::load_global(const std::string& name) const {
+    auto global = globals_->find(name);
+    if (global != globals_->end()) {
+        return global->second;
+    }
 
-            if (is_type<bool>(left_val) && is_type<bool>(right_val)) {
-                return get_value<bool>(left_val) && get_value<bool>(right_val);
-            }
+    // todo: reference ??
+    return NULL_VALUE;
+}
 
-            throw ExecutionError("Logical AND not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
+void Executor::store_global(const std::string& name, const Value& val) {
+    if (globals_.use_count() > 1) {
+        globals_ = std::make_shared<ValueMap>(*globals_);
+    }
+    // 全局变量比 init 的临时分配区活得久，需要复制到全局分配区；其中的延迟值解码后再共享
+    (*globals_)[std::pmr::string(name)] = promote(val, *globals_arena_);
+}
+
+bool Executor::run_native(const Function* func, const Value* args, size_t argc, Value& result) const {
+    NativeFunction native = Jit::instance().lookup(func, *globals_, module_);
+    if (!native || argc != func->parameters.size() || argc > 8) {
+        return false;
+    }
+
+    // 类型守卫：参数不是int时回退到解释器
+    int32_t native_args[8];
+    for (size_t i = 0; i < argc; ++i) {
+        if (!args[i].is_int()) {
+            return false;
         }
+        native_args[i] = args[i].as_int();
+    }
 
-        case ExprNode::OpType::OR: {
-            Value left_val = evaluate_expression(expr->left.get());
-            Value right_val = evaluate_expression(expr->right.get());
+    int32_t ok = 1;
+    int32_t ret = native(native_args, &ok);
+    if (!ok) {
+        return false;
+    }
 
-            if (is_type<bool>(left_val) && is_type<bool>(right_val)) {
-                return get_value<bool>(left_val) || get_value<bool>(right_val);
-            }
+    result = ret;
+    return true;
+}
 
-            throw ExecutionError("Logical OR not supported for types: " +
-                                get_type_name(left_val) + " and " + get_type_name(right_val));
-        }
+Value Executor::run(const Function* func, Values args) {
+    const size_t entry = frames_.size();
+    const size_t base = stack_.size();
 
-        case ExprNode::OpType::NOT: {
-            Value val = evaluate_expression(expr->left.get());
+    // 与 CALL 相同的栈布局：[函数, 实参...]
+    stack_.push_back(Value::function(func));
+    stack_.insert(stack_.end(), std::make_move_iterator(args.begin()), std::make_move_iterator(args.end()));
 
-            if (is_type<bool>(val)) {
-                return !get_value<bool>(val);
-            }
+    Value result;
+    if (run_native(func, stack_.data() + base + 1, args.size(), result)) {
+        stack_.resize(base);
+        return result;
+    }
+    push_frame(func, base + 1);
 
-            throw ExecutionError("Logical NOT not supported for type: " + get_type_name(val));
-        }
+    // 同步执行：在 <- 处阻塞等待响应后继续
+    while (!dispatch(entry, base, result)) {
+        deliver(Singleflight::instance().get(pending_urls_));
+    }
+    return result;
+}
 
-        case ExprNode::OpType::ASSIGN: {
-            if (!expr->left || expr->left->op_type != ExprNode::OpType::IDENTIFIER) {
-                throw ExecutionError("Invalid assignment target");
-            }
+bool Executor::dispatch(size_t entry, size_t base, Value& result) {
+    try {
+        while (true) {
+            Frame& frame = frames_.back();
+            const Instruction& ins = *frame.ip++;
+            const auto& constants = frame.function->chunk.constants;
+
+            switch (ins.op) {
+                case OpCode::CONST:
+                    stack_.push_back(constants[ins.a]);
+                    break;
 
-            std::string var_name = expr->left->value;
-            Value val = evaluate_expression(expr->right.get());
-            variables[var_name] = val;
-            return val;
-        }
+                case OpCode::LOAD_LOCAL:
+                    stack_.push_back(stack_[frame.base + ins.a]);
+                    break;
 
-            // 处理数组字面量
-        case ExprNode::OpType::ARRAY_LITERAL: {
-            // 在堆上创建数组（手动分配，不会自动销毁）
-            auto* array = new std::vector<Value>();
-            for (const auto& elem_node : expr->array_elements) {
-                array->push_back(evaluate_expression(elem_node.get()));
-            }
+                case OpCode::STORE_LOCAL:
+                    stack_[frame.base + ins.a] = stack_.back();
+                    break;
 
-            // 存入全局容器，确保生命周期
-            //g_all_arrays.push_back(array);
+                case OpCode::LOAD_GLOBAL:
+                    stack_.push_back(load_global(constants[ins.a].as_string()));
+                    break;
 
-            // 转换为void*返回
-            return std::make_pair(1, array);
-        }
+                case OpCode::STORE_GLOBAL:
+                    store_global(constants[ins.a].as_string(), stack_.back());
+                    break;
 
-        case ExprNode::OpType::ARRAY_ACCESS: { // 处理数组访问
-            if (!expr->left || !expr->right) {
-                throw ExecutionError("Invalid array access expression");
-            }
+                case OpCode::POP:
+                    stack_.pop_back();
+                    break;
 
-            // 获取数组
-            Value array_val = evaluate_expression(expr->left.get());
+                case OpCode::FIELD:
+                    stack_.back() = get_object_field(stack_.back(), constants[ins.a].as_string());
+                    break;
 
-            // 获取索引（必须是整数）
-            Value index_val = evaluate_expression(expr->right.get());
-            if (!is_type<int>(index_val)) {
-                throw ExecutionError("Array index must be an integer");
-            }
+                case OpCode::ELEMENT:
+                    stack_.back() = get_array_element(stack_.back(), static_cast<size_t>(ins.a));
+                    break;
 
-            int index = get_value<int>(index_val);
-            if (index < 0) {
-                throw ExecutionError("Negative array index: " + std::to_string(index));
-            }
+                case OpCode::INDEX: {
+                    Value index_val = stack_.back();
+                    stack_.pop_back();
 
-            return get_array_element(array_val, static_cast<size_t>(index));
-        }
+                    if (index_val.is_string()) {
+                        stack_.back() = get_object_field(stack_.back(), index_val.as_string());
+                        break;
+                    }
+                    if (!index_val.is_int()) {
+                        throw ExecutionError("Array index must be an integer");
+                    }
 
-        case ExprNode::OpType::OBJECT_LITERAL: {
-            auto* val = new std::unordered_map<std::string, Value>();
-            for (const auto& [key, value] : expr->object_members) {
-                (*val)[key] = evaluate_expression(value.get());
-            }
-            return std::make_pair(2, val);
-        }
+                    int index = index_val.as_int();
+                    if (index < 0) {
+                        throw ExecutionError("Negative array index: " + std::to_string(index));
+                    }
+                    stack_.back() = get_array_element(stack_.back(), static_cast<size_t>(index));
+                    break;
+                }
 
-        case ExprNode::OpType::CURL: {
-            if (!expr->left || !expr->right) {
-                throw ExecutionError("Invalid curl expression");
-            }
-            if (!expr->left || expr->left->op_type != ExprNode::OpType::IDENTIFIER) {
-                throw ExecutionError("Invalid assignment target");
-            }
+                case OpCode::CALL: {
+                    const size_t callee = stack_.size() - ins.a - 1;
+                    const Function* target = as_function(stack_[callee]);
 
-            Value data_val = evaluate_expression(expr->left.get());
+                    Value native_result;
+                    if (run_native(target, stack_.data() + callee + 1, ins.a, native_result)) {
+                        stack_.resize(callee);
+                        stack_.push_back(native_result);
+                        break;
+                    }
 
-            Value url_val = evaluate_expression(expr->right.get());
-            if (!is_type<std::string>(url_val)) {
-                throw ExecutionError("curl path must be a string");
-            }
+                    // 实参原地成为被调用者的前几个局部变量
+                    push_frame(target, callee + 1);
+                    break;
+                }
 
-            std::string url = get_value<std::string>(url_val);
-            std::string ret = http_get(url);
+                case OpCode::ADD:
+                case OpCode::SUB:
+                case OpCode::MUL:
+                case OpCode::DIV: {
+                    Value right_val = stack_.back();
+                    stack_.pop_back();
+                    stack_.back() = arithmetic(ins.op, stack_.back(), right_val, *arena_);
+                    break;
+                }
 
-            try {
-                // 核心：将字符串解析为 json 对象（decode 过程）
-                json j = json::parse(ret);
-                auto jval = json_to_value(j);
-                variables[expr->left->value] = jval;
-                return jval;
-            } catch (const json::parse_error& e) {
-                return 0;
-            }
-        }
+                case OpCode::EQ:
+                case OpCode::NEQ: {
+                    Value right_val = stack_.back();
+                    stack_.pop_back();
+                    bool equal = stack_.back() == right_val;
+                    stack_.back() = ins.op == OpCode::EQ ? equal : !equal;
+                    break;
+                }
 
-        default:
-            throw ExecutionError("Unsupported expression: " + expr->to_string());
-    }
-}
+                case OpCode::LT:
+                case OpCode::GT:
+                case OpCode::LE:
+                case OpCode::GE: {
+                    Value right_val = stack_.back();
+                    stack_.pop_back();
+                    stack_.back() = compare(ins.op, stack_.back(), right_val);
+                    break;
+                }
 
-void Executor::execute_statement(const StmtNode* stmt) {
-    if (!stmt) {
-        return;
-    }
+                case OpCode::AND:
+                case OpCode::OR: {
+                    Value right_val = stack_.back();
+                    stack_.pop_back();
+                    Value& left_val = stack_.back();
 
-    switch (stmt->stmt_type) {
-        case StmtNode::StmtType::EXPRESSION: {
-            if (stmt->expr) {
-                evaluate_expression(stmt->expr.get());
-            }
-            break;
-        }
+                    if (!left_val.is_bool() || !right_val.is_bool()) {
+                        throw ExecutionError(std::string(ins.op == OpCode::AND ? "Logical AND" : "Logical OR") +
+                                             " not supported for types: " +
+                                             get_type_name(left_val) + " and " + get_type_name(right_val));
+                    }
 
-        case StmtNode::StmtType::BLOCK: {
-            for (const auto& child : stmt->children) {
-                execute_statement(child.get());
-                if (return_) {
-                    return_ = false;
+                    bool l = left_val.as_bool();
+                    bool r = right_val.as_bool();
+                    left_val = ins.op == OpCode::AND ? (l && r) : (l || r);
                     break;
                 }
-            }
-            break;
-        }
 
-        case StmtNode::StmtType::IF: {
-            if (!stmt->condition) {
-                throw ExecutionError("If statement missing condition");
-            }
+                case OpCode::NOT: {
+                    Value& val = stack_.back();
+                    if (!val.is_bool()) {
+                        throw ExecutionError("Logical NOT not supported for type: " + get_type_name(val));
+                    }
+                    val = !val.as_bool();
+                    break;
+                }
 
-            Value cond_val = evaluate_expression(stmt->condition.get());
-            if (!is_type<bool>(cond_val)) {
-                throw ExecutionError("If condition must be a boolean");
-            }
+                case OpCode::ARRAY: {
+                    // 在分配区中创建数组，随请求一起释放
+                    Values* array = arena_->new_array();
+                    array->assign(stack_.end() - ins.a, stack_.end());
+                    stack_.resize(stack_.size() - ins.a);
+                    stack_.push_back(Value::array(array));
+                    break;
+                }
 
-            if (get_value<bool>(cond_val)) {
-                if (!stmt->children.empty()) {
-                    execute_statement(stmt->children[0].get());
+                case OpCode::OBJECT: {
+                    ValueMap* object = arena_->new_object();
+                    const size_t first = stack_.size() - 2 * ins.a;
+                    object->reserve(ins.a);
+                    for (size_t i = first; i < stack_.size(); i += 2) {
+                        object->insert_or_assign(std::pmr::string(stack_[i].as_string(), arena_->resource()), stack_[i + 1]);
+                    }
+                    stack_.resize(first);
+                    stack_.push_back(Value::object(object));
+                    break;
                 }
-            } else if (stmt->children.size() >= 2) {
-                execute_statement(stmt->children[1].get());
-            }
-            break;
-        }
 
-        case StmtNode::StmtType::WHILE: {
-            if (!stmt->condition) {
-                throw ExecutionError("While statement missing condition");
-            }
+                case OpCode::CURL: {
+                    // 命中缓存时直接压入缓存的值，否则挂起执行，由调用者取得响应体后压入解码结果再继续（见 run 与 resume）
+                    // 之前 FETCH 而尚未等待的请求一起发出
+                    if (request(ins, PUSH_RESULT)) {
+                        return false;
+                    }
+                    break;
+                }
 
-            while (true) {
-                Value cond_val = evaluate_expression(stmt->condition.get());
-                if (!is_type<bool>(cond_val) || !get_value<bool>(cond_val)) {
+                case OpCode::FETCH: {
+                    request(ins, frame.base + ins.a);
                     break;
                 }
 
-                if (!stmt->children.empty()) {
-                    execute_statement(stmt->children[0].get());
+                case OpCode::AWAIT: {
+                    if (!pending_urls_.empty()) {
+                        return false;
+                    }
+                    break;
                 }
-            }
-            break;
-        }
 
-        case StmtNode::StmtType::FOR: {
-            // 执行初始化语句
-            if (stmt->children.size() >= 1 && stmt->children[0]) {
-                execute_statement(stmt->children[0].get());
-            }
+                case OpCode::JUMP:
+                    frame.ip = frame.function->chunk.code.data() + ins.a;
+                    break;
+
+                case OpCode::JUMP_IF_FALSE: {
+                    Value cond_val = stack_.back();
+                    stack_.pop_back();
+
+                    if (!cond_val.is_bool()) {
+                        if (!ins.b) {
+                            throw ExecutionError("If condition must be a boolean");
+                        }
+                        frame.ip = frame.function->chunk.code.data() + ins.a;
+                    } else if (!cond_val.as_bool()) {
+                        frame.ip = frame.function->chunk.code.data() + ins.a;
+                    }
+                    break;
+                }
 
-            // 循环条件检查和执行循环体
-            while (true) {
-                // 检查循环条件
-                if (stmt->condition) {
-                    Value cond_val = evaluate_expression(stmt->condition.get());
-                    if (!is_type<bool>(cond_val) || !get_value<bool>(cond_val)) {
+                case OpCode::EACH: {
+                    const size_t top = stack_.size();
+                    const auto& array = cast_to_array(stack_[top - 3]);
+                    int i = stack_[top - 2].as_int();
+                    int j = stack_[top - 1].as_int();
+
+                    // 依次遍历所有 i < j 的元素对
+                    const int size = static_cast<int>(array.size());
+                    while (i < size && j >= size) {
+                        ++i;
+                        j = i + 1;
+                    }
+                    if (i >= size) {
+                        stack_.resize(top - 3);
+                        frame.ip = frame.function->chunk.code.data() + ins.a;
                         break;
                     }
-                } else {
-                    // 没有条件的for循环是无限循环
+
+                    Value first = array[i];
+                    Value second = array[j];
+                    stack_[top - 2] = i;
+                    stack_[top - 1] = j + 1;
+                    stack_.push_back(first);
+                    stack_.push_back(second);
+                    break;
                 }
 
-                // 执行循环体
-                if (stmt->children.size() >= 2 && stmt->children[1]) {
-                    execute_statement(stmt->children[1].get());
+                case OpCode::PRINT: {
+                    for (size_t i = stack_.size() - ins.a; i < stack_.size(); ++i) {
+                        os << value_to_string(stack_[i]);
+                    }
+                    os << std::endl;
+                    stack_.resize(stack_.size() - ins.a);
+                    break;
                 }
 
-                // 执行迭代语句
-                if (stmt->children.size() >= 3 && stmt->children[2]) {
-                    execute_statement(stmt->children[2].get());
+                case OpCode::RETURN: {
+                    result = stack_.back();
+                    const size_t result_slot = frame.result_slot;
+                    stack_.resize(frame.base - 1);
+                    frames_.pop_back();
+                    if (frames_.size() == entry) {
+                        return true;
+                    }
+                    write_result(result_slot, result);
+                    break;
                 }
-            }
-            break;
-        }
 
-        case StmtNode::StmtType::RETURN: {
-            if (stmt->expr) {
-                result_ = evaluate_expression(stmt->expr.get());
-                return_ = true;
+                default:
+                    throw ExecutionError(std::string("Unsupported instruction: ") + opcode_name(ins.op));
             }
-            break;
         }
+    } catch (...) {
+        // 出错时丢弃本次调用产生的帧和操作数，以及尚未发出的请求
+        frames_.resize(entry);
+        stack_.resize(base);
+        pending_urls_.clear();
+        pending_slots_.clear();
+        pending_ttls_.clear();
+        throw;
+    }
+}
 
-        case StmtNode::StmtType::PRINT: {
-            Values results;
-            for (const auto& expr : stmt->exprs) {
-                results.emplace_back(evaluate_expression(expr.get()));
-            }
-
-            for (auto i = 0; i < results.size(); ++i) {
-                os << value_to_string(results[i]);
-            }
-            os << std::endl;
-            break;
+// 执行时间有上限的函数：没有调用、网络请求、打印，也没有循环
+static bool is_cheap_function(const Function* func) {
+    const auto& code = func->chunk.code;
+    for (size_t i = 0; i < code.size(); ++i) {
+        switch (code[i].op) {
+            case OpCode::CALL:
+            case OpCode::CURL:
+            case OpCode::FETCH:
+            case OpCode::PRINT:
+            case OpCode::EACH:
+                return false;
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+                if (code[i].a <= static_cast<int>(i)) {
+                    return false;
+                }
+                break;
+            default:
+                break;
         }
+    }
+    return true;
+}
 
-        case StmtNode::StmtType::DECLARATION: {
-            Value result = evaluate_expression(stmt->expr.get());
-            break;
-        }
+// 结果只取决于常量和 init 后的全局变量的函数：没有参数（路由参数），在 is_cheap_function 的基础上也没有全局写入
+static bool is_constant_function(const Function* func) {
+    const auto& code = func->chunk.code;
+    return func->parameters.empty() && is_cheap_function(func) && std::none_of(code.begin(), code.end(), [](const Instruction& ins) {
+        return ins.op == OpCode::STORE_GLOBAL;
+    });
+}
 
-        case StmtNode::StmtType::EACH: {
-            const auto expr = stmt->expr.get();
+const Function* Executor::api_function(const APINode* api) const {
+    auto it = module_->apis.find(api);
+    return it != module_->apis.end() ? it->second.get() : nullptr;
+}
 
-            // 获取数组
-            auto array_val = cast_to_array(variables[expr->value]);
-            auto p0 = expr->parameters[0];
-            auto p1 = expr->parameters[1];
+bool Executor::execute_api(const Router::Match& match, Value& result) {
+    if (!match.api) {
+        throw ExecutionError("null api");
+    }
 
-            // 循环条件检查和执行循环体
-            for (auto i = 0; i < array_val.size(); i++) {
-                for (auto j = i + 1; j < array_val.size(); j++) {
-                    variables[p0] = array_val[i];
-                    variables[p1] = array_val[j];
+    auto it = module_->apis.find(match.api);
+    if (it == module_->apis.end()) {
+        throw ExecutionError("api not compiled: " + match.api->path);
+    }
 
-                    // 检查循环条件
-                    Value cond_val = evaluate_expression(stmt->condition.get());
-                    if (!is_type<bool>(cond_val) || !get_value<bool>(cond_val)) {
-                        continue;
-                    }
+    const Function* func = it->second.get();
+    stack_.push_back(Value::function(func));
+    push_arguments(match);
+    if (run_native(func, stack_.data() + 1, match.arguments.size(), result)) {
+        stack_.clear();
+        return true;
+    }
+    push_frame(func, 1);
+    return dispatch(0, 0, result);
+}
 
-                    // 执行循环体
-                    execute_statement(stmt->children[0].get());
-                }
-            }
-            break;
+bool Executor::request(const Instruction& ins, size_t slot) {
+    // b=1 时缓存时长在 url 上方
+    int ttl = -1;
+    if (ins.b) {
+        Value ttl_val = stack_.back();
+        stack_.pop_back();
+        if (!ttl_val.is_int()) {
+            throw ExecutionError("cache ttl must be an integer");
         }
-
-        case StmtNode::StmtType::EMPTY:
-            // 空语句，什么都不做
-            break;
-
-        default:
-            throw ExecutionError("Unsupported statement: " + stmt->to_string());
+        ttl = std::max(ttl_val.as_int(), 0);
     }
-}
 
-Value Executor::execute_function(const FuncNode* func, const std::vector<Value>& args) {
-    if (!func) {
-        throw ExecutionError("null function");
+    Value url_val = stack_.back();
+    stack_.pop_back();
+    if (!url_val.is_string()) {
+        throw ExecutionError("curl path must be a string");
     }
 
-    // 保存当前变量状态，用于函数执行完毕后恢复
-    auto prev_variables = variables;
+    // 本进程的 api：与函数调用一样执行，返回值直接作为结果，不经过网络和 JSON 编解码
+    Router::Match match;
+    if (local_route(url_val.as_string(), match)) {
+        const Function* api = module_->apis.at(match.api).get();
+        size_t base = stack_.size() + 1;
+        stack_.push_back(Value::function(api));
+        push_arguments(match);
+
+        Value native_result;
+        if (run_native(api, stack_.data() + base, match.arguments.size(), native_result)) {
+            stack_.resize(base - 1);
+            write_result(slot, native_result);
+            return false;
+        }
+        push_frame(api, base, slot);
+        return false;
+    }
 
-    try {
-        // 设置函数参数
-        for (size_t i = 0; i < func->parameters.size() && i < args.size(); ++i) {
-            variables[func->parameters[i]] = args[i];
+    if (ttl != 0) {
+        if (auto cached = ResponseCache::instance().lookup(url_val.as_string())) {
+            write_result(slot, *cached);
+            cached_.push_back(std::move(cached));
+            return false;
         }
+    }
 
-        // 执行函数体
-        if (func->body) {
-            execute_statement(func->body.get());
-        }
+    pending_urls_.push_back(url_val.as_string());
+    pending_slots_.push_back(slot);
+    pending_ttls_.push_back(ttl);
+    return true;
+}
 
-        return result_;
-    } catch (...) {
-        // 恢复变量状态并重新抛出异常
-        variables = prev_variables;
-        throw;
+void Executor::write_result(size_t slot, const Value& value) {
+    if (slot == PUSH_RESULT) {
+        stack_.push_back(value);
+    } else {
+        stack_[slot] = value;
     }
 }
 
-Value Executor::execute_api(const APINode* api) {
-    if (!api) {
-        throw ExecutionError("null api");
+void Executor::deliver(Singleflight::Flights flights) {
+    // 请求失败（包括超时）时本次执行以错误结束，合并的请求都收到同一个错误
+    for (size_t i = 0; i < flights.size(); ++i) {
+        const auto& response = flights[i]->response();
+        if (!response.error.empty()) {
+            std::string message = "<- " + pending_urls_[i] + ": " + response.error;
+            pending_urls_.clear();
+            pending_slots_.clear();
+            pending_ttls_.clear();
+            throw UpstreamError(message, response.timed_out);
+        }
     }
 
-    // 保存当前变量状态，用于函数执行完毕后恢复
-    auto prev_variables = variables;
+    for (size_t i = 0; i < flights.size(); ++i) {
+        auto& flight = *flights[i];
+        const auto& response = flight.response();
+        auto ttl = pending_ttls_[i] >= 0 ? std::chrono::seconds(pending_ttls_[i]) : response.max_age;
 
-    try {
-        // 执行函数体
-        execute_statement(api->body.get());
+        // 与其他请求合并的响应只解码一次，共享解码结果
+        if (flight.shared()) {
+            auto value = flight.value(ttl);
+            write_result(pending_slots_[i], *value);
+            cached_.push_back(std::move(value));
+            continue;
+        }
 
-        return result_;
-    } catch (...) {
-        // 恢复变量状态并重新抛出异常
-        variables = prev_variables;
-        throw;
+        // 可缓存的响应完全解码后放入缓存，与其他请求共享
+        if (ttl.count() > 0 && !response.body.empty()) {
+            if (auto cached = ResponseCache::instance().store(pending_urls_[i], response.body, ttl)) {
+                write_result(pending_slots_[i], *cached);
+                cached_.push_back(std::move(cached));
+                continue;
+            }
+        }
+
+        // 由响应体构建 Value（decode 过程），数组、对象在按路径访问时才解码
+        write_result(pending_slots_[i], parse_json(flight.take_body(), *arena_));
     }
+    pending_urls_.clear();
+    pending_slots_.clear();
+    pending_ttls_.clear();
+}
+
+bool Executor::resume(Singleflight::Flights flights, Value& result) {
+    deliver(std::move(flights));
+    return dispatch(0, 0, result);
 }
 
 namespace net = boost::asio;            // from <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
 
-void Executor::execute(const std::unique_ptr<ProgramNode>& program) {
-    if (!program) {
+void Executor::execute(const std::unique_ptr<ProgramNode>& program, std::shared_ptr<const Module> module) {
+    if (!program || !module) {
         throw ExecutionError("null program");
     }
 
-    for (auto& [name, func] : program->functions) {
-        std::unique_ptr<FuncNode> new_owner = std::move(func);
-        variables[name] = std::make_pair(3, new_owner.release());
+    module_ = std::move(module);
+
+    for (const auto& func : module_->functions) {
+        (*globals_)[std::pmr::string(func->name)] = Value::function(func.get());
     }
 
-    for (auto& [name, value] : variables) {
-        if (name == "init") {
-            execute_function(as_function(value), {});
+    // 解释器模式不监听端口，其余模式下 <- 可以直接调用本进程的 api
+    if (!eval_) {
+        auto routes = std::make_shared<Routes>();
+        for (const auto& api : program->apis) {
+            (*routes)[api->port].add(api->path, api.get());
         }
+        routes_ = std::move(routes);
+    }
+
+    // init 的临时值和 <- 的响应（原文、结构索引）分配在临时分配区中，init 结束后释放
+    // 写入全局变量的值由 store_global 复制到全局分配区
+    auto init = globals_->find("init");
+    if (init != globals_->end()) {
+        Arena scratch;
+        Arena* arena = std::exchange(arena_, &scratch);
+        try {
+            run(as_function(init->second), {});
+        } catch (...) {
+            arena_ = arena;
+            throw;
+        }
+        arena_ = arena;
     }
 
     if (eval_) {
@@ -748,38 +752,67 @@ void Executor::execute(const std::unique_ptr<ProgramNode>& program) {
     // 要监听的端口列表
     std::unordered_map<int, std::unordered_map<std::string, std::unique_ptr<APINode>>> apisByPort;
 
+    // 常量 api 的响应体，init 之后全局变量不再变化，只需计算一次
+    std::unordered_map<int, std::unordered_map<std::string, std::string>> bodiesByPort;
+
     // 执行全局语句
     for (auto& api : program->apis) {
-        std::cout << "listen :" << api->port << " " << api->path << std::endl;
+        std::cout << "listen :" << api->port << " " << api->path;
+
+        const Function* func = module_->apis.at(api.get()).get();
+
+        // 执行时间有上限的 api 总是直接在 I/O 线程上执行，其余没有参数的按测得的耗时决定
+        if (is_cheap_function(func)) {
+            func->cost_ns = 0;
+        }
+
+        if (is_constant_function(func)) {
+            try {
+                bodiesByPort[api->port][api->path] = ::value_to_string(run(func, {}), Listener::response_indent);
+                std::cout << " (constant)";
+            } catch (const std::runtime_error&) {
+                // 出错的 api 每次请求时报告错误
+            }
+        }
+        std::cout << std::endl;
+
         apisByPort[api->port][api->path] = std::move(api);
     }
 
     try
     {
-        // 关键：添加容器存储 Listener 的 shared_ptr，确保生命周期
-        std::vector<std::shared_ptr<Listener>> listeners;
+        // 每个反应器线程运行一个单线程的 io_context，连接的读写都在接受它的线程上完成
+        std::vector<std::unique_ptr<net::io_context>> reactors;
+        for (size_t i = 0; i < std::max<size_t>(Listener::reactors, 1); ++i) {
+            reactors.push_back(std::make_unique<net::io_context>(1));
+        }
 
-        net::io_context ioc{3};  // 1 表示线程池大小（单线程）
+        // 关键：添加容器存储 Listener 的 shared_ptr，确保生命周期（先于 io_context 销毁）
+        std::vector<std::shared_ptr<Listener>> listeners;
 
-        // 为每个端口创建并运行监听器
+        // 为每个端口在每个反应器上创建并运行监听器（apisByPort 在 io_context 运行期间保持有效）
         for (auto& [port, apis] : apisByPort) {
             auto const address = net::ip::make_address("0.0.0.0");
             auto const endpoint = tcp::endpoint{address, static_cast<unsigned short>(port)};
 
-            // 方案A：若需保留 apisByPort（传递 shared_ptr，不移动）
-            auto listener = std::make_shared<Listener>(ioc, endpoint, std::move(apis));
-
-            // 方案B：若无需保留 apisByPort（传递移动后的 map，原代码逻辑）
-            // auto listener = std::make_shared<Listener>(ioc, endpoint, std::move(apis));
-
-            listeners.push_back(listener);  // 保存到容器，防止销毁
-            listener->run();  // 启动监听器
+            for (auto& ioc : reactors) {
+                auto listener = std::make_shared<Listener>(*ioc, endpoint, apis, bodiesByPort[port]);
+                listeners.push_back(listener);  // 保存到容器，防止销毁
+                listener->run();  // 启动监听器
+            }
         }
 
         std::cout << "Servers started." << std::endl;
 
         // 运行IO服务（此时 listeners 持有 Listener，确保其存活）
-        ioc.run();
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < reactors.size(); ++i) {
+            threads.emplace_back([&ioc = *reactors[i]] { ioc.run(); });
+        }
+        reactors[0]->run();
+        for (auto& thread : threads) {
+            thread.join();
+        }
     }
     catch (std::exception const& e)
     {
@@ -790,7 +823,7 @@ void Executor::execute(const std::unique_ptr<ProgramNode>& program) {
 void Executor::print_variables() const {
     std::cout << "\nFinal Variables:" << std::endl;
     std::cout << "==========" << std::endl;
-    for (const auto& [name, val] : variables) {
+    for (const auto& [name, val] : *globals_) {
         std::cout << name << " = " << value_to_string(val) << " (" << get_type_name(val) << ")" << std::endl;
     }
 }
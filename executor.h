@@ -1,160 +1,31 @@
 #ifndef GLUE_EXECUTOR_H
 #define GLUE_EXECUTOR_H
 
-#include <unordered_map>
-#include <variant>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
-#include "json.hpp"
+#include "arena.h"
+#include "bytecode.h"
 #include "parser.h"
+#include "router.h"
+#include "singleflight.h"
+#include "value.h"
+
+// 调用帧：参数与局部变量占用操作数栈上 [base, base + slots) 的位置，其下方是被调用的函数
+struct Frame {
+    const Function* function;
+    const Instruction* ip;  // 下一条待执行指令
+    size_t base;            // 第一个局部变量槽位在操作数栈上的位置
+    size_t result_slot;     // 返回值写入的操作数栈位置，SIZE_MAX 表示压入栈顶（FETCH 本进程的 api 时使用）
+};
 
-#define NULL_VALUE 0
-
-using json = nlohmann::json;
-
-// 支持的数据类型
-using ComplexValue = std::pair<int, void*>;
-using Value = std::variant<int, float, std::string, bool, ComplexValue>;
-using Values = std::vector<Value>;
-using ValueMap = std::unordered_map<std::string, Value>;
-
-// 向前声明转换函数
-inline std::string value_to_string(const Value& value);
-inline void to_json(json& j, const Values& vs);
-inline void to_json(json& j, const ValueMap& vm);
-
-// 自定义序列化函数，用于处理 Value variant
-inline void to_json(json& j, const Value& v) {
-    std::visit([&j](const auto& arg) {
-        using T = std::decay_t<decltype(arg)>;
-        if constexpr (std::is_same_v<T, ComplexValue>) {
-            switch (arg.first) {
-                case 1: { // vector
-                    auto vec = *reinterpret_cast<Values*>(arg.second);
-                    to_json(j, vec);
-                    break;
-                }
-                case 2: { // unorder_map
-                    // 安全转换 void* → std::unordered_map<Value, Value>*
-                    auto map = *reinterpret_cast<ValueMap*>(arg.second);
-                    to_json(j, map);
-                    break;
-                }
-            }
-        } else {
-            j = arg;
-        }
-    }, v);
-}
-
-// 自定义序列化函数，用于处理 Values vector
-inline void to_json(json& j, const Values& vs) {
-    j = json::array();
-    for (const auto& v : vs) {
-        json temp;
-        to_json(temp, v);
-        j.push_back(temp);
-    }
-}
-
-// 自定义序列化函数，用于处理 ValueMap unordered_map
-inline void to_json(json& j, const ValueMap& vm) {
-    j = json::object();
-    for (const auto& [key, value] : vm) {
-        json temp;
-        to_json(temp, value);
-        j[key] = temp;
-    }
-}
-
-// 自定义序列化函数，用于处理 ComplexValue
-inline void to_json(json& j, const ComplexValue& cv) {
-    switch (cv.first) {
-        case 1: { // vector
-            auto vec = *reinterpret_cast<Values*>(cv.second);
-            to_json(j, vec);
-            break;
-        }
-        case 2: { // unorder_map
-            // 安全转换 void* → std::unordered_map<Value, Value>*
-            auto map = *reinterpret_cast<ValueMap*>(cv.second);
-            to_json(j, map);
-            break;
-        }
-    }
-}
-
-inline std::string value_to_string(const Value& value) {
-    json j;
-    to_json(j, value);
-    return j.dump(4);
-}
-
-// 向前声明转换函数
-inline Value json_to_value(const nlohmann::json& j);
-inline Values json_to_values(const nlohmann::json& j);
-inline ValueMap json_to_value_map(const nlohmann::json& j);
-
-// 核心转换函数：将json转换为Value
-inline Value json_to_value(const nlohmann::json& j) {
-    if (j.is_null()) {
-        // 处理null：可根据需求映射为特定值（这里示例映射为int 0）
-        return 0;
-    }
-    else if (j.is_boolean()) {
-        // 布尔值 -> bool
-        return j.get<bool>();
-    }
-    else if (j.is_number_integer()) {
-        // 整数 -> int
-        return j.get<int>();
-    }
-    else if (j.is_number_float()) {
-        // 浮点数 -> float
-        return static_cast<float>(j.get<double>());
-    }
-    else if (j.is_string()) {
-        // 字符串 -> std::string
-        return j.get<std::string>();
-    }
-    else if (j.is_array()) {
-        // 数组 -> 特殊处理：这里示例将数组包装为ComplexValue（int标记+指针）
-        // 注意：实际使用中需管理内存，避免内存泄漏
-        Values* arr = new Values(json_to_values(j));
-        return ComplexValue(1, arr);  // 用int=1标记这是数组类型
-    }
-    else if (j.is_object()) {
-        // 对象 -> 特殊处理：包装为ComplexValue（int标记+指针）
-        ValueMap* obj = new ValueMap(json_to_value_map(j));
-        return ComplexValue(2, obj);  // 用int=2标记这是对象类型
-    }
-    else {
-        throw std::invalid_argument("不支持的JSON类型");
-    }
-}
-
-// 辅助函数：将json数组转换为Values（vector<Value>）
-inline Values json_to_values(const nlohmann::json& j) {
-    assert(j.is_array() && "输入必须是JSON数组");
-    Values values;
-    for (const auto& elem : j) {
-        values.push_back(json_to_value(elem));
-    }
-    return values;
-}
-
-// 辅助函数：将json对象转换为ValueMap（unordered_map<string, Value>）
-inline ValueMap json_to_value_map(const nlohmann::json& j) {
-    assert(j.is_object() && "输入必须是JSON对象");
-    ValueMap map;
-    for (const auto& [key, value] : j.items()) {
-        map[key] = json_to_value(value);
-    }
-    return map;
-}
-
-// 执行器类，用于解释执行AST
+// 执行器类：基于栈的字节码虚拟机
 class Executor {
 private:
     std::ostream& os;
@@ -163,40 +34,100 @@ private:
 
     bool eval_ = false;
 
-    bool return_ = false;
+    // 编译后的程序（请求间共享）
+    std::shared_ptr<const Module> module_;
 
-    // 结果存储
-    Value result_;
+    // 全局变量存储（函数、init 中定义的变量），与 copy() 出的执行器共享，写时复制
+    std::shared_ptr<ValueMap> globals_ = std::make_shared<ValueMap>();
 
-    // 变量存储
-    std::unordered_map<std::string, Value> variables;
+    // 新建数组、对象所在的分配区，以及全局变量所在的分配区
+    Arena* arena_ = &Arena::global();
+    Arena* globals_arena_ = &Arena::global();
+
+    // 操作数栈与调用栈
+    Values stack_;
+    std::vector<Frame> frames_;
 
     // 辅助函数：获取值的字符串表示
     [[nodiscard]] std::string value_to_string(const Value& val) const;
 
-    Value evaluate_address_index(const ExprNode* expr);
+    // 压入调用帧，实参已位于栈上 base 处
+    void push_frame(const Function* func, size_t base, size_t result_slot = PUSH_RESULT);
+
+    // 本进程监听的 api，按端口分别路由，与 copy() 出的执行器共享
+    using Routes = std::unordered_map<int, Router>;
+    std::shared_ptr<const Routes> routes_ = std::make_shared<Routes>();
 
-    // 表达式求值
-    Value evaluate_expression(const ExprNode* expr);
+    // url 指向本进程的 api 时匹配它并返回 true，<- 直接调用而不经过网络（参数是 url 的视图）
+    bool local_route(const std::string& url, Router::Match& match) const;
 
-    // 语句执行
-    void execute_statement(const StmtNode* stmt);
+    // 解码匹配到的参数，作为 api 的实参依次压入栈（请求中没有的查询参数为空值）
+    void push_arguments(const Router::Match& match);
 
-    // 执行函数
-    Value execute_function(const FuncNode* func, const std::vector<Value>& args);
+    // 读写全局变量
+    Value load_global(const std::string& name) const;
+    void store_global(const std::string& name, const Value& val);
+
+    // 尝试以JIT生成的本地代码执行（参数须均为int）
+    bool run_native(const Function* func, const Value* args, size_t argc, Value& result) const;
+
+    // 挂起时待请求的 <- 地址，各自的结果写入的操作数栈位置（PUSH_RESULT 表示压入栈顶）
+    // 以及缓存时长（秒，-1 表示按响应头决定）
+    static constexpr size_t PUSH_RESULT = SIZE_MAX;
+    std::vector<std::string> pending_urls_;
+    std::vector<size_t> pending_slots_;
+    std::vector<int> pending_ttls_;
+
+    // 引用过的缓存条目和共享的解码结果，执行器销毁前不会释放（init 的执行器引用到进程退出）
+    std::vector<std::shared_ptr<const Value>> cached_;
+
+    // 弹出 CURL / FETCH 的操作数：本进程的 api 压入调用帧、命中缓存时写入结果，返回 false；否则记录待发出的请求并返回 true
+    bool request(const Instruction& ins, size_t slot);
+    void write_result(size_t slot, const Value& value);
+
+    // 解码响应体（可缓存的放入缓存，合并的请求共享解码结果）并写入各自的位置
+    void deliver(Singleflight::Flights flights);
+
+    // 同步执行函数，<- 阻塞等待响应
+    Value run(const Function* func, Values args);
+
+    // 分派循环：执行到调用帧回到 entry 层时返回 true，结果写入 result；遇到 <- 时挂起并返回 false
+    // 出错时丢弃 entry 之后的帧和 base 之后的操作数
+    bool dispatch(size_t entry, size_t base, Value& result);
 public:
     explicit Executor() : os(std::cout) {};
 
-    explicit Executor(bool eval /* true */) : eval_(true), os(oss) {};
+    // eval 模式：所有值都分配在 arena 中，随本次求值一起释放
+    explicit Executor(bool eval /* true */, Arena& arena)
+        : eval_(true), os(oss), arena_(&arena), globals_arena_(&arena) {};
 
     // 执行整个程序
-    void execute(const std::unique_ptr<ProgramNode>& program);
+    void execute(const std::unique_ptr<ProgramNode>& program, std::shared_ptr<const Module> module);
+
+    // 在新 copy() 出的执行器上异步执行 api：执行完成时返回 true，结果写入 result
+    // 遇到 <- 时挂起并返回 false，调用者并发请求 pending_urls()，按相同顺序取得响应体后调用 resume 继续
+    // 有请求失败或超时时 resume 抛出 UpstreamError
+    // 参数在调用期间解码，match 的视图只需在 execute_api 返回前有效
+    bool execute_api(const Router::Match& match, Value& result);
+    bool resume(Singleflight::Flights flights, Value& result);
 
-    Value execute_api(const APINode*);
+    // api 编译后的函数，未编译时返回空
+    [[nodiscard]] const Function* api_function(const APINode* api) const;
+
+    [[nodiscard]] const std::vector<std::string>& pending_urls() const {
+        return pending_urls_;
+    }
+
+    // 本次请求新建的数组、对象分配在 arena 中，调用者在响应序列化后 reset
+    void use_arena(Arena& arena) {
+        arena_ = &arena;
+    }
 
     [[nodiscard]] Executor copy() const {
         Executor exe;
-        exe.variables = this->variables;
+        exe.module_ = this->module_;
+        exe.globals_ = this->globals_;
+        exe.routes_ = this->routes_;
         return exe;
     }
 
@@ -208,12 +139,29 @@ public:
     };
 };
 
+// 算术（ADD/SUB/MUL/DIV）与比较（LT/GT/LE/GE）运算，类型不支持时抛出 ExecutionError
+// 解释器与常量折叠共用，保证两者结果一致；拼接的字符串分配在 arena 中
+Value arithmetic(OpCode op, const Value& left_val, const Value& right_val, Arena& arena);
+Value compare(OpCode op, const Value& left_val, const Value& right_val);
+
 // 执行时异常
 class ExecutionError : public std::runtime_error {
 public:
     explicit ExecutionError(const std::string& message) : std::runtime_error(message) {}
 };
 
+// <- 的请求失败或超时
+class UpstreamError final : public ExecutionError {
+    bool timed_out_;
+
+public:
+    UpstreamError(const std::string& message, bool timed_out) : ExecutionError(message), timed_out_(timed_out) {}
+
+    [[nodiscard]] bool timed_out() const {
+        return timed_out_;
+    }
+};
+
 inline Executor executor;
 
 #endif // EXECUTOR_H
@@ -0,0 +1,381 @@
+//
+// Created by ezzno on 2025/9/15.
+//
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+#include "arena.h"
+#include "image.h"
+#include "jit.h"
+
+namespace {
+
+// 文件末尾的标记：[镜像长度 8 字节][魔数 8 字节]
+constexpr char MAGIC[8] = {'R', 'O', '-', 'I', 'M', 'A', 'G', 'E'};
+constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(MAGIC);
+constexpr uint32_t VERSION = 4;
+
+// 常量的类型标记
+enum class Tag : uint8_t { INT, FLOAT, STRING, BOOL, ARRAY, OBJECT };
+
+class Writer {
+private:
+    std::string out_;
+
+public:
+    template<typename T>
+    void put(T value) {
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void put(std::string_view value) {
+        put(static_cast<uint32_t>(value.size()));
+        out_.append(value);
+    }
+
+    void put(const std::string& value) {
+        put(std::string_view(value));
+    }
+
+    void put(const Value& value) {
+        if (value.is_int()) {
+            put(Tag::INT);
+            put(value.as_int());
+        } else if (value.is_float()) {
+            put(Tag::FLOAT);
+            put(value.as_float());
+        } else if (value.is_string()) {
+            put(Tag::STRING);
+            put(value.as_string());
+        } else if (value.is_bool()) {
+            put(Tag::BOOL);
+            put(value.as_bool());
+        } else if (value.is_array()) {
+            const auto& array = value.as_array();
+            put(Tag::ARRAY);
+            put(static_cast<uint32_t>(array.size()));
+            for (const auto& elem : array) {
+                put(elem);
+            }
+        } else if (value.is_object()) {
+            const auto& object = value.as_object();
+            put(Tag::OBJECT);
+            put(static_cast<uint32_t>(object.size()));
+            for (const auto& [key, elem] : object) {
+                put(std::string_view(key));
+                put(elem);
+            }
+        } else {
+            throw ImageError("function constant cannot be saved");
+        }
+    }
+
+    void put(const Function& func) {
+        put(func.name);
+        put(static_cast<uint32_t>(func.parameters.size()));
+        for (const auto& parameter : func.parameters) {
+            put(parameter);
+        }
+        put(func.global_scope);
+        put(static_cast<uint32_t>(func.slots.size()));
+        for (const auto& slot : func.slots) {
+            put(slot);
+        }
+
+        put(static_cast<uint32_t>(func.chunk.code.size()));
+        for (const auto& ins : func.chunk.code) {
+            put(ins.op);
+            put(ins.a);
+            put(ins.b);
+        }
+
+        put(static_cast<uint32_t>(func.chunk.constants.size()));
+        for (const auto& constant : func.chunk.constants) {
+            put(constant);
+        }
+    }
+
+    std::string& str() {
+        return out_;
+    }
+};
+
+class Reader {
+private:
+    const std::string& in_;
+    StringPool& strings_;
+    size_t pos_ = 0;
+
+    void need(size_t size) const {
+        if (in_.size() - pos_ < size) {
+            throw ImageError("truncated image");
+        }
+    }
+
+public:
+    Reader(const std::string& in, StringPool& strings) : in_(in), strings_(strings) {}
+
+    template<typename T>
+    T get() {
+        need(sizeof(T));
+        T value;
+        std::memcpy(&value, in_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string get_string() {
+        auto size = get<uint32_t>();
+        need(size);
+        std::string value = in_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+
+    Value get_value() {
+        switch (get<Tag>()) {
+            case Tag::INT: return get<int>();
+            case Tag::FLOAT: return get<float>();
+            case Tag::STRING: return strings_.intern(get_string());
+            case Tag::BOOL: return get<bool>();
+            case Tag::ARRAY: {
+                // 预构建的常量与 init 中的全局值一样，存活于整个进程
+                Values* array = Arena::global().new_array();
+                array->resize(get<uint32_t>());
+                for (auto& elem : *array) {
+                    elem = get_value();
+                }
+                return Value::array(array);
+            }
+            case Tag::OBJECT: {
+                ValueMap* object = Arena::global().new_object();
+                auto size = get<uint32_t>();
+                for (uint32_t i = 0; i < size; ++i) {
+                    auto key = get_string();
+                    (*object)[std::pmr::string(key)] = get_value();
+                }
+                return Value::object(object);
+            }
+        }
+        throw ImageError("unknown constant type");
+    }
+
+    std::unique_ptr<Function> get_function() {
+        auto func = std::make_unique<Function>();
+        func->name = get_string();
+        func->parameters.resize(get<uint32_t>());
+        for (auto& parameter : func->parameters) {
+            parameter = get_string();
+        }
+        func->global_scope = get<bool>();
+        func->slots.resize(get<uint32_t>());
+        for (auto& slot : func->slots) {
+            slot = get_string();
+        }
+
+        func->chunk.code.resize(get<uint32_t>());
+        for (auto& ins : func->chunk.code) {
+            ins.op = get<OpCode>();
+            ins.a = get<int32_t>();
+            ins.b = get<int32_t>();
+        }
+
+        func->chunk.constants.resize(get<uint32_t>());
+        for (auto& constant : func->chunk.constants) {
+            constant = get_value();
+        }
+        return func;
+    }
+};
+
+std::string executable_path() {
+#ifdef __APPLE__
+    uint32_t size = 0;
+    _NSGetExecutablePath(nullptr, &size);
+    std::string path(size, '\0');
+    if (_NSGetExecutablePath(path.data(), &size) != 0) {
+        throw ImageError("cannot locate executable");
+    }
+    return path.c_str();
+#else
+    return "/proc/self/exe";
+#endif
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw ImageError("cannot read " + path);
+    }
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// 返回可执行文件中镜像的起始位置，没有镜像时返回文件长度
+size_t image_offset(const std::string& binary) {
+    if (binary.size() < TRAILER_SIZE ||
+        std::memcmp(binary.data() + binary.size() - sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0) {
+        return binary.size();
+    }
+
+    uint64_t size;
+    std::memcpy(&size, binary.data() + binary.size() - TRAILER_SIZE, sizeof(size));
+    if (size > binary.size() - TRAILER_SIZE) {
+        throw ImageError("corrupted image");
+    }
+    return binary.size() - TRAILER_SIZE - size;
+}
+
+// 函数在镜像中的顺序：先普通函数，再按声明顺序排列的 api
+std::vector<const Function*> ordered_functions(const ProgramNode& program, const Module& module) {
+    std::vector<const Function*> functions;
+    for (const auto& func : module.functions) {
+        functions.push_back(func.get());
+    }
+    for (const auto& api : program.apis) {
+        functions.push_back(module.apis.at(api.get()).get());
+    }
+    return functions;
+}
+
+// 预编译时可见的全局名称：函数，以及 init 中写入的变量（运行时才有值，不能当作函数）
+ValueMap compile_time_globals(const Module& module) {
+    ValueMap globals;
+    for (const auto& func : module.functions) {
+        globals[std::pmr::string(func->name)] = Value::function(func.get());
+    }
+    for (const auto& func : module.functions) {
+        for (const auto& ins : func->chunk.code) {
+            if (ins.op == OpCode::STORE_GLOBAL) {
+                globals[std::pmr::string(func->chunk.constants[ins.a].as_string())] = NULL_VALUE;
+            }
+        }
+    }
+    return globals;
+}
+
+} // namespace
+
+void write_executable(const std::string& output, const ProgramNode& program, const Module& module) {
+    Writer writer;
+    writer.put(VERSION);
+
+    writer.put(static_cast<uint32_t>(module.functions.size()));
+    for (const auto& func : module.functions) {
+        writer.put(*func);
+    }
+
+    writer.put(static_cast<uint32_t>(program.apis.size()));
+    for (const auto& api : program.apis) {
+        writer.put(api->path);
+        writer.put(static_cast<int32_t>(api->port));
+        writer.put(*module.apis.at(api.get()));
+    }
+
+    // 能降低为本地代码的函数提前编译，启动后直接执行
+    std::vector<std::pair<int, std::string>> symbols;
+    std::string object = Jit::instance().compile_object(ordered_functions(program, module),
+                                                        compile_time_globals(module), symbols);
+    writer.put(object);
+    writer.put(static_cast<uint32_t>(symbols.size()));
+    for (const auto& [index, symbol] : symbols) {
+        writer.put(static_cast<int32_t>(index));
+        writer.put(symbol);
+    }
+
+    // 以当前可执行文件（去掉已有镜像）作为运行时
+    std::string binary = read_file(executable_path());
+    binary.resize(image_offset(binary));
+
+    const uint64_t size = writer.str().size();
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw ImageError("cannot write " + output);
+    }
+    out.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+    out.write(writer.str().data(), static_cast<std::streamsize>(size));
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(MAGIC, sizeof(MAGIC));
+    out.close();
+    if (!out) {
+        throw ImageError("cannot write " + output);
+    }
+
+    chmod(output.c_str(), 0755);
+}
+
+std::unique_ptr<Image> load_embedded_image() {
+    // 只读取末尾的标记和镜像，不加载整个可执行文件
+    std::ifstream in(executable_path(), std::ios::binary | std::ios::ate);
+    if (!in) {
+        return nullptr;
+    }
+    const uint64_t file_size = in.tellg();
+    if (file_size < TRAILER_SIZE) {
+        return nullptr;
+    }
+
+    char trailer[TRAILER_SIZE];
+    in.seekg(static_cast<std::streamoff>(file_size - TRAILER_SIZE));
+    in.read(trailer, TRAILER_SIZE);
+    if (!in || std::memcmp(trailer + sizeof(uint64_t), MAGIC, sizeof(MAGIC)) != 0) {
+        return nullptr;
+    }
+
+    uint64_t size;
+    std::memcpy(&size, trailer, sizeof(size));
+    if (size > file_size - TRAILER_SIZE) {
+        throw ImageError("corrupted image");
+    }
+
+    std::string payload(size, '\0');
+    in.seekg(static_cast<std::streamoff>(file_size - TRAILER_SIZE - size));
+    in.read(payload.data(), static_cast<std::streamsize>(size));
+    if (!in) {
+        throw ImageError("truncated image");
+    }
+
+    auto image = std::make_unique<Image>();
+    image->program = std::make_unique<ProgramNode>();
+    image->module = std::make_shared<Module>();
+    image->program->strings = image->module->strings;
+
+    Reader reader(payload, *image->module->strings);
+    if (reader.get<uint32_t>() != VERSION) {
+        throw ImageError("unsupported image version");
+    }
+
+    auto function_count = reader.get<uint32_t>();
+    for (uint32_t i = 0; i < function_count; ++i) {
+        image->module->functions.push_back(reader.get_function());
+    }
+
+    auto api_count = reader.get<uint32_t>();
+    for (uint32_t i = 0; i < api_count; ++i) {
+        auto api = std::make_unique<APINode>(reader.get_string());
+        api->port = reader.get<int32_t>();
+        image->module->apis[api.get()] = reader.get_function();
+        image->program->apis.push_back(std::move(api));
+    }
+
+    auto functions = ordered_functions(*image->program, *image->module);
+    image->object = reader.get_string();
+    auto symbol_count = reader.get<uint32_t>();
+    for (uint32_t i = 0; i < symbol_count; ++i) {
+        auto index = reader.get<int32_t>();
+        auto symbol = reader.get_string();
+        if (index < 0 || static_cast<size_t>(index) >= functions.size()) {
+            throw ImageError("corrupted image");
+        }
+        image->symbols.emplace_back(functions[index], std::move(symbol));
+    }
+
+    return image;
+}
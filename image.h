@@ -0,0 +1,40 @@
+//
+// Created by ezzno on 2025/9/15.
+//
+
+#ifndef GLUE_IMAGE_H
+#define GLUE_IMAGE_H
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bytecode.h"
+#include "parser.h"
+
+// 程序镜像：字节码、api 表以及预编译的本地代码
+// --output 时附加在 ro-glue 可执行文件末尾，启动时无需再词法、语法分析和编译
+struct Image {
+    std::unique_ptr<ProgramNode> program;  // 只包含 api 的路径与端口
+    std::shared_ptr<Module> module;
+
+    // 预编译的目标文件及其导出的函数
+    std::string object;
+    std::vector<std::pair<const Function*, std::string>> symbols;
+};
+
+// 将程序与当前可执行文件一起写为独立的可执行文件
+void write_executable(const std::string& output, const ProgramNode& program, const Module& module);
+
+// 读取当前可执行文件附带的镜像，没有时返回 nullptr
+std::unique_ptr<Image> load_embedded_image();
+
+// 镜像读写异常
+class ImageError final : public std::runtime_error {
+public:
+    explicit ImageError(const std::string& message) : std::runtime_error(message) {}
+};
+
+#endif // GLUE_IMAGE_H
@@ -0,0 +1,580 @@
+//
+// Created by ezzno on 2025/9/14.
+//
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include "jit.h"
+#include "workers.h"
+
+struct Jit::Engine {
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::ExecutionEngine> engine;
+
+    ~Engine() {
+        // 先释放引擎（持有模块），再释放上下文
+        engine.reset();
+        context.reset();
+    }
+};
+
+namespace {
+
+// 编译期的栈元素类型
+enum class Kind { INT, BOOL, FUNC };
+
+struct Slot {
+    Kind kind;
+    llvm::Value* value = nullptr;
+    const Function* callee = nullptr;
+};
+
+// 不支持的字节码，放弃编译
+struct Unsupported {};
+
+// 将一组字节码函数降低为 LLVM IR
+class Lowering {
+private:
+    llvm::LLVMContext& ctx_;
+    llvm::Module& module_;
+    const ValueMap& globals_;
+
+    llvm::Type* i32_;
+    llvm::PointerType* ptr_;
+    llvm::FunctionType* type_;
+
+    std::unordered_map<const Function*, llvm::Function*> functions_;
+    std::vector<const Function*> pending_;
+
+    static const std::string& name_of(const Function* func, int index) {
+        const auto& constant = func->chunk.constants[index];
+        if (!constant.is_string()) {
+            throw Unsupported{};
+        }
+        return constant.as_string();
+    }
+
+    static Slot pop(std::vector<Slot>& stack, Kind kind) {
+        if (stack.empty() || stack.back().kind != kind) {
+            throw Unsupported{};
+        }
+        Slot slot = stack.back();
+        stack.pop_back();
+        return slot;
+    }
+
+    void define(const Function* func) {
+        llvm::Function* fn = functions_.at(func);
+        const auto& code = func->chunk.code;
+
+        // init 的变量写入全局变量表
+        if (func->global_scope) {
+            throw Unsupported{};
+        }
+
+        auto* entry = llvm::BasicBlock::Create(ctx_, "entry", fn);
+        llvm::IRBuilder<> b(entry);
+        llvm::IRBuilder<> allocas(entry);
+
+        llvm::Value* args = fn->getArg(0);
+        llvm::Value* ok = fn->getArg(1);
+
+        // 参数与局部变量：每个槽位一个 alloca，未赋值的局部变量为空值 0
+        std::vector<llvm::Value*> locals;
+        for (size_t i = 0; i < func->slots.size(); ++i) {
+            auto* slot = b.CreateAlloca(i32_, nullptr, func->slots[i]);
+            if (i < func->parameters.size()) {
+                auto index = b.getInt32(static_cast<int>(i));
+                b.CreateStore(b.CreateLoad(i32_, b.CreateInBoundsGEP(i32_, args, index)), slot);
+            } else {
+                b.CreateStore(b.getInt32(0), slot);
+            }
+            locals.push_back(slot);
+        }
+
+        // 跳转目标各自成块
+        std::map<int, llvm::BasicBlock*> blocks;
+        for (size_t i = 0; i < code.size(); ++i) {
+            if (code[i].op == OpCode::JUMP || code[i].op == OpCode::JUMP_IF_FALSE) {
+                blocks.emplace(code[i].a, nullptr);
+            }
+            if (code[i].op == OpCode::JUMP_IF_FALSE) {
+                blocks.emplace(static_cast<int>(i) + 1, nullptr);
+            }
+        }
+        for (auto& [target, block] : blocks) {
+            block = llvm::BasicBlock::Create(ctx_, "L" + std::to_string(target), fn);
+        }
+
+        // 回退块：通知调用者改用解释器
+        auto* bail = llvm::BasicBlock::Create(ctx_, "bail", fn);
+        {
+            llvm::IRBuilder<> bb(bail);
+            bb.CreateStore(bb.getInt32(0), ok);
+            bb.CreateRet(bb.getInt32(0));
+        }
+
+        auto* body = llvm::BasicBlock::Create(ctx_, "body", fn, blocks.empty() ? bail : blocks.begin()->second);
+        b.CreateBr(body);
+        b.SetInsertPoint(body);
+
+        std::vector<Slot> stack;
+        bool terminated = false;
+
+        for (size_t i = 0; i < code.size(); ++i) {
+            const auto& ins = code[i];
+
+            auto target = blocks.find(static_cast<int>(i));
+            if (target != blocks.end()) {
+                // 语句边界以外的跳转不支持
+                if (!stack.empty()) {
+                    throw Unsupported{};
+                }
+                if (!terminated) {
+                    b.CreateBr(target->second);
+                }
+                b.SetInsertPoint(target->second);
+                terminated = false;
+            } else if (terminated) {
+                // 不可达代码，放入孤立块
+                b.SetInsertPoint(llvm::BasicBlock::Create(ctx_, "dead", fn));
+                stack.clear();
+                terminated = false;
+            }
+
+            switch (ins.op) {
+                case OpCode::CONST: {
+                    const auto& constant = func->chunk.constants[ins.a];
+                    if (constant.is_int()) {
+                        stack.push_back({Kind::INT, b.getInt32(constant.as_int())});
+                    } else if (constant.is_bool()) {
+                        stack.push_back({Kind::BOOL, b.getInt1(constant.as_bool())});
+                    } else {
+                        throw Unsupported{};
+                    }
+                    break;
+                }
+
+                case OpCode::LOAD_LOCAL:
+                    stack.push_back({Kind::INT, b.CreateLoad(i32_, locals.at(ins.a))});
+                    break;
+
+                case OpCode::LOAD_GLOBAL: {
+                    // 全局名称只允许是函数
+                    auto global = globals_.find(name_of(func, ins.a));
+                    if (global == globals_.end() || !global->second.is_function()) {
+                        throw Unsupported{};
+                    }
+                    auto callee = global->second.as_function();
+                    stack.push_back({Kind::FUNC, nullptr, callee});
+                    break;
+                }
+
+                case OpCode::STORE_LOCAL: {
+                    if (stack.empty() || stack.back().kind != Kind::INT) {
+                        throw Unsupported{};
+                    }
+                    b.CreateStore(stack.back().value, locals.at(ins.a));
+                    break;
+                }
+
+                case OpCode::POP:
+                    if (stack.empty()) {
+                        throw Unsupported{};
+                    }
+                    stack.pop_back();
+                    break;
+
+                case OpCode::CALL: {
+                    if (stack.size() < static_cast<size_t>(ins.a) + 1) {
+                        throw Unsupported{};
+                    }
+                    const Slot& callee = stack[stack.size() - ins.a - 1];
+                    if (callee.kind != Kind::FUNC ||
+                        callee.callee->parameters.size() != static_cast<size_t>(ins.a)) {
+                        throw Unsupported{};
+                    }
+
+                    llvm::Value* call_args = llvm::ConstantPointerNull::get(ptr_);
+                    if (ins.a > 0) {
+                        auto* array_type = llvm::ArrayType::get(i32_, ins.a);
+                        allocas.SetInsertPoint(entry, entry->begin());
+                        auto* array = allocas.CreateAlloca(array_type);
+                        for (int k = 0; k < ins.a; ++k) {
+                            const Slot& arg = stack[stack.size() - ins.a + k];
+                            if (arg.kind != Kind::INT) {
+                                throw Unsupported{};
+                            }
+                            b.CreateStore(arg.value, b.CreateInBoundsGEP(array_type, array,
+                                                                         {b.getInt32(0), b.getInt32(k)}));
+                        }
+                        call_args = b.CreateInBoundsGEP(array_type, array, {b.getInt32(0), b.getInt32(0)});
+                    }
+
+                    llvm::Value* result = b.CreateCall(type_, declare(callee.callee), {call_args, ok});
+                    stack.resize(stack.size() - ins.a - 1);
+
+                    // 被调用者回退时，整个调用链一起回退
+                    auto* cont = llvm::BasicBlock::Create(ctx_, "cont", fn);
+                    b.CreateCondBr(b.CreateICmpEQ(b.CreateLoad(i32_, ok), b.getInt32(0)), bail, cont);
+                    b.SetInsertPoint(cont);
+
+                    stack.push_back({Kind::INT, result});
+                    break;
+                }
+
+                case OpCode::ADD:
+                case OpCode::SUB:
+                case OpCode::MUL:
+                case OpCode::DIV: {
+                    llvm::Value* r = pop(stack, Kind::INT).value;
+                    llvm::Value* l = pop(stack, Kind::INT).value;
+                    llvm::Value* v;
+                    switch (ins.op) {
+                        case OpCode::ADD: v = b.CreateAdd(l, r); break;
+                        case OpCode::SUB: v = b.CreateSub(l, r); break;
+                        case OpCode::MUL: v = b.CreateMul(l, r); break;
+                        default: {
+                            // 除零（以及 INT_MIN / -1）交给解释器报错
+                            auto* zero = b.CreateICmpEQ(r, b.getInt32(0));
+                            auto* overflow = b.CreateAnd(b.CreateICmpEQ(l, b.getInt32(INT32_MIN)),
+                                                         b.CreateICmpEQ(r, b.getInt32(-1)));
+                            auto* cont = llvm::BasicBlock::Create(ctx_, "div", fn);
+                            b.CreateCondBr(b.CreateOr(zero, overflow), bail, cont);
+                            b.SetInsertPoint(cont);
+                            v = b.CreateSDiv(l, r);
+                        }
+                    }
+                    stack.push_back({Kind::INT, v});
+                    break;
+                }
+
+                case OpCode::EQ:
+                case OpCode::NEQ: {
+                    if (stack.size() < 2 || stack.back().kind == Kind::FUNC ||
+                        stack[stack.size() - 2].kind != stack.back().kind) {
+                        throw Unsupported{};
+                    }
+                    Kind kind = stack.back().kind;
+                    llvm::Value* r = pop(stack, kind).value;
+                    llvm::Value* l = pop(stack, kind).value;
+                    stack.push_back({Kind::BOOL, ins.op == OpCode::EQ ? b.CreateICmpEQ(l, r) : b.CreateICmpNE(l, r)});
+                    break;
+                }
+
+                case OpCode::LT:
+                case OpCode::GT:
+                case OpCode::LE:
+                case OpCode::GE: {
+                    llvm::Value* r = pop(stack, Kind::INT).value;
+                    llvm::Value* l = pop(stack, Kind::INT).value;
+                    llvm::Value* v;
+                    switch (ins.op) {
+                        case OpCode::LT: v = b.CreateICmpSLT(l, r); break;
+                        case OpCode::GT: v = b.CreateICmpSGT(l, r); break;
+                        case OpCode::LE: v = b.CreateICmpSLE(l, r); break;
+                        default: v = b.CreateICmpSGE(l, r); break;
+                    }
+                    stack.push_back({Kind::BOOL, v});
+                    break;
+                }
+
+                case OpCode::AND:
+                case OpCode::OR: {
+                    llvm::Value* r = pop(stack, Kind::BOOL).value;
+                    llvm::Value* l = pop(stack, Kind::BOOL).value;
+                    stack.push_back({Kind::BOOL, ins.op == OpCode::AND ? b.CreateAnd(l, r) : b.CreateOr(l, r)});
+                    break;
+                }
+
+                case OpCode::NOT:
+                    stack.push_back({Kind::BOOL, b.CreateNot(pop(stack, Kind::BOOL).value)});
+                    break;
+
+                case OpCode::JUMP:
+                    if (!stack.empty()) {
+                        throw Unsupported{};
+                    }
+                    b.CreateBr(blocks.at(ins.a));
+                    terminated = true;
+                    break;
+
+                case OpCode::JUMP_IF_FALSE: {
+                    llvm::Value* cond = pop(stack, Kind::BOOL).value;
+                    if (!stack.empty()) {
+                        throw Unsupported{};
+                    }
+                    b.CreateCondBr(cond, blocks.at(static_cast<int>(i) + 1), blocks.at(ins.a));
+                    terminated = true;
+                    break;
+                }
+
+                case OpCode::RETURN:
+                    b.CreateRet(pop(stack, Kind::INT).value);
+                    stack.clear();
+                    terminated = true;
+                    break;
+
+                default:
+                    // 对象、数组、字符串、网络请求、打印等留在解释器中
+                    throw Unsupported{};
+            }
+        }
+
+        if (!terminated) {
+            throw Unsupported{};
+        }
+    }
+
+public:
+    Lowering(llvm::LLVMContext& ctx, llvm::Module& module, const ValueMap& globals)
+        : ctx_(ctx), module_(module), globals_(globals) {
+        i32_ = llvm::Type::getInt32Ty(ctx_);
+#if LLVM_VERSION_MAJOR >= 17
+        ptr_ = llvm::PointerType::get(ctx_, 0);
+#else
+        ptr_ = llvm::Type::getInt32PtrTy(ctx_);
+#endif
+        type_ = llvm::FunctionType::get(i32_, {ptr_, ptr_}, false);
+    }
+
+    // 声明函数，稍后由 run 统一定义
+    llvm::Function* declare(const Function* func) {
+        auto it = functions_.find(func);
+        if (it != functions_.end()) {
+            return it->second;
+        }
+
+        auto* fn = llvm::Function::Create(type_, llvm::Function::ExternalLinkage,
+                                          "ro_fn_" + std::to_string(functions_.size()), module_);
+        functions_[func] = fn;
+        pending_.push_back(func);
+        return fn;
+    }
+
+    // 定义所有已声明的函数；任一函数不支持时返回 false
+    bool run() {
+        try {
+            while (!pending_.empty()) {
+                const Function* func = pending_.back();
+                pending_.pop_back();
+                define(func);
+                if (llvm::verifyFunction(*functions_.at(func))) {
+                    return false;
+                }
+            }
+        } catch (const Unsupported&) {
+            return false;
+        }
+        return true;
+    }
+
+    const std::unordered_map<const Function*, llvm::Function*>& functions() const {
+        return functions_;
+    }
+};
+
+llvm::ExecutionEngine* create_engine(std::unique_ptr<llvm::Module> ir) {
+    std::string error;
+    return llvm::EngineBuilder(std::move(ir))
+        .setErrorStr(&error)
+        .setEngineKind(llvm::EngineKind::JIT)
+#if LLVM_VERSION_MAJOR >= 18
+        .setOptLevel(llvm::CodeGenOptLevel::Aggressive)
+#else
+        .setOptLevel(llvm::CodeGenOpt::Aggressive)
+#endif
+        .create();
+}
+
+} // namespace
+
+Jit::Jit() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+}
+
+Jit::~Jit() = default;
+
+Jit& Jit::instance() {
+    static Jit jit;
+    return jit;
+}
+
+NativeFunction Jit::lookup(const Function* func, const ValueMap& globals,
+                          const std::shared_ptr<const Module>& module) {
+    NativeFunction native = func->native.load(std::memory_order_acquire);
+    if (native) {
+        return native;
+    }
+
+    const uint32_t threshold = threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) {
+        return nullptr;
+    }
+
+    // 恰好达到阈值的那次调用负责提交编译，失败后不再尝试
+    if (func->hits.fetch_add(1, std::memory_order_relaxed) + 1 != threshold) {
+        return nullptr;
+    }
+
+    // 编译需要毫秒级的时间并持有全局锁，不能在内联执行 api 的 I/O 线程上进行
+    // 编译只用到全局变量中的函数，复制一份；任务持有 module，编译完成前模块不会释放
+    auto functions = std::make_shared<ValueMap>();
+    for (const auto& [name, value] : globals) {
+        if (value.is_function()) {
+            functions->emplace(name, value);
+        }
+    }
+    WorkerPool::instance().submit([this, func, functions, module] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        compile(func, *functions, *module);
+    });
+    return nullptr;
+}
+
+void Jit::compile(const Function* func, const ValueMap& globals, const Module& module) {
+    auto engine = std::make_unique<Engine>();
+    engine->context = std::make_unique<llvm::LLVMContext>();
+
+    auto ir = std::make_unique<llvm::Module>("ro_jit", *engine->context);
+    Lowering lowering(*engine->context, *ir, globals);
+    lowering.declare(func);
+    if (!lowering.run()) {
+        return;
+    }
+
+    // 记录函数名，模块所有权转移后仍可查找地址
+    std::vector<std::pair<const Function*, std::string>> symbols;
+    for (const auto& [compiled, fn] : lowering.functions()) {
+        symbols.emplace_back(compiled, fn->getName().str());
+    }
+
+    engine->engine.reset(create_engine(std::move(ir)));
+    if (!engine->engine) {
+        return;
+    }
+    install(std::move(engine), symbols, module);
+}
+
+void Jit::install(std::unique_ptr<Engine> engine,
+                  const std::vector<std::pair<const Function*, std::string>>& symbols, const Module& module) {
+    engine->engine->finalizeObject();
+
+    for (const auto& [compiled, symbol] : symbols) {
+        auto address = engine->engine->getFunctionAddress(symbol);
+        if (address != 0 && !compiled->native.load(std::memory_order_acquire)) {
+            compiled->native.store(reinterpret_cast<NativeFunction>(address), std::memory_order_release);
+        }
+    }
+
+    // 本地代码只被 module 中的函数引用，与它们一起释放（--eval 每次求值编译的代码不会累积）
+    module.native_code.push_back(std::shared_ptr<Engine>(std::move(engine)));
+}
+
+std::string Jit::compile_object(const std::vector<const Function*>& functions, const ValueMap& globals,
+                                std::vector<std::pair<int, std::string>>& symbols) {
+    llvm::LLVMContext context;
+
+    // 逐个试编译，只保留整条调用链都可编译的函数
+    std::vector<int> roots;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        llvm::Module scratch("ro_probe", context);
+        Lowering probe(context, scratch, globals);
+        probe.declare(functions[i]);
+        if (probe.run()) {
+            roots.push_back(static_cast<int>(i));
+        }
+    }
+    if (roots.empty()) {
+        return "";
+    }
+
+    llvm::Module ir("ro_aot", context);
+    Lowering lowering(context, ir, globals);
+    for (int root : roots) {
+        lowering.declare(functions[root]);
+    }
+    if (!lowering.run()) {
+        return "";
+    }
+
+    // 与 JIT 使用相同的目标机器配置
+    std::unique_ptr<llvm::TargetMachine> target(llvm::EngineBuilder()
+#if LLVM_VERSION_MAJOR >= 18
+                                                    .setOptLevel(llvm::CodeGenOptLevel::Aggressive)
+#else
+                                                    .setOptLevel(llvm::CodeGenOpt::Aggressive)
+#endif
+                                                    .selectTarget());
+    if (!target) {
+        return "";
+    }
+    ir.setDataLayout(target->createDataLayout());
+#if LLVM_VERSION_MAJOR >= 21
+    ir.setTargetTriple(target->getTargetTriple());
+#else
+    ir.setTargetTriple(target->getTargetTriple().str());
+#endif
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream os(buffer);
+    llvm::legacy::PassManager passes;
+#if LLVM_VERSION_MAJOR >= 18
+    if (target->addPassesToEmitFile(passes, os, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+#else
+    if (target->addPassesToEmitFile(passes, os, nullptr, llvm::CGFT_ObjectFile)) {
+#endif
+        return "";
+    }
+    passes.run(ir);
+
+    // 只导出根函数的符号，被调用者随目标文件一起加载
+    for (int root : roots) {
+        symbols.emplace_back(root, lowering.functions().at(functions[root])->getName().str());
+    }
+    return {buffer.begin(), buffer.end()};
+}
+
+bool Jit::load_object(const std::string& object,
+                      const std::vector<std::pair<const Function*, std::string>>& symbols, const Module& module) {
+    if (object.empty()) {
+        return false;
+    }
+
+    auto memory = llvm::MemoryBuffer::getMemBufferCopy(object, "ro_aot");
+    auto file = llvm::object::ObjectFile::createObjectFile(memory->getMemBufferRef());
+    if (!file) {
+        llvm::consumeError(file.takeError());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto engine = std::make_unique<Engine>();
+    engine->context = std::make_unique<llvm::LLVMContext>();
+    engine->engine.reset(create_engine(std::make_unique<llvm::Module>("ro_aot", *engine->context)));
+    if (!engine->engine) {
+        return false;
+    }
+    engine->engine->addObjectFile(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*file),
+                                                                                     std::move(memory)));
+    install(std::move(engine), symbols, module);
+    return true;
+}
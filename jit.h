@@ -0,0 +1,64 @@
+//
+// Created by ezzno on 2025/9/14.
+//
+
+#ifndef GLUE_JIT_H
+#define GLUE_JIT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bytecode.h"
+#include "value.h"
+
+// JIT 编译层：调用次数达到阈值的函数（及 api）被编译为本地代码
+// 仅支持 int/bool 运算、局部变量、分支循环以及对同类函数的调用，其余情况留在解释器中执行
+class Jit {
+private:
+    struct Engine;
+
+    // 保护编译过程以及各模块的 native_code
+    std::mutex mutex_;
+
+    std::atomic<uint32_t> threshold_{1000};
+
+    Jit();
+
+    // 编译 func 及其调用到的所有函数（都属于 module），成功后写入各自的 native
+    void compile(const Function* func, const ValueMap& globals, const Module& module);
+
+    // 完成代码生成，写入各函数的 native，引擎交给 module 持有（调用者持有 mutex_）
+    void install(std::unique_ptr<Engine> engine,
+                 const std::vector<std::pair<const Function*, std::string>>& symbols, const Module& module);
+
+public:
+    ~Jit();
+
+    static Jit& instance();
+
+    // 设置热点阈值，0 表示关闭 JIT
+    void set_threshold(uint32_t threshold) {
+        threshold_ = threshold;
+    }
+
+    // 记录一次调用，返回可用的本地代码（尚未编译或无法编译时返回 nullptr）
+    // 达到阈值时在线程池中编译，调用者不等待（可能在 I/O 线程上），编译完成前继续解释执行
+    // 生成的代码由 func 所属的 module 持有，随模块一起释放
+    NativeFunction lookup(const Function* func, const ValueMap& globals, const std::shared_ptr<const Module>& module);
+
+    // 预编译：将 functions 中所有可编译的函数生成为一个目标文件
+    // symbols 记录函数在 functions 中的下标及其符号名
+    std::string compile_object(const std::vector<const Function*>& functions, const ValueMap& globals,
+                               std::vector<std::pair<int, std::string>>& symbols);
+
+    // 加载预编译的目标文件，写入 module 中各函数的 native；失败时返回 false，函数留在解释器中执行
+    bool load_object(const std::string& object,
+                     const std::vector<std::pair<const Function*, std::string>>& symbols, const Module& module);
+};
+
+#endif // GLUE_JIT_H
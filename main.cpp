@@ -1,15 +1,27 @@
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
 #include <boost/url.hpp>
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
+#include "absl/strings/str_split.h"
 #include "json.hpp"
+#include "cache.h"
+#include "client.h"
+#include "compiler.h"
 #include "executor.h"
+#include "image.h"
+#include "jit.h"
+#include "optimizer.h"
 #include "parser.h"
+#include "router.h"
 #include "server.h"
+#include "singleflight.h"
+#include "workers.h"
 #include "lexer.h"
 #include "main.h"
 
@@ -18,24 +30,68 @@ ABSL_FLAG(bool, debug, false, "Enable debug mode (print AST and IR)");
 ABSL_FLAG(bool, eval, false, "Enable eval mode (no api and listen)");
 ABSL_FLAG(int, port, 8080, "Port to listen on");
 ABSL_FLAG(std::string, output, "", "Output executable filename");
-
-std::string eval(const std::string& input) {
-    try {
-        Lexer lexer(input, true);
-        Parser parser(lexer);
-        std::unique_ptr<ProgramNode> program = parser.parse_program();
-        Executor executor(true);
-        executor.execute(program);
-        return executor.result();
-    } catch (const std::runtime_error& e) {
-        return e.what();
-    }
-}
+ABSL_FLAG(int, jit_threshold, 1000, "Calls before a function is JIT compiled (0 disables the JIT)");
+ABSL_FLAG(int, keep_alive_timeout, 30, "Seconds an idle inbound keep-alive connection is kept open");
+ABSL_FLAG(int, keep_alive_requests, 1000, "Max requests served on one inbound connection before it is closed");
+ABSL_FLAG(int, pipeline_depth, 16, "Max pipelined requests read ahead and executed concurrently per connection");
+ABSL_FLAG(int, reactors, 0, "Reactor threads accepting and serving connections (0 uses one per core)");
+ABSL_FLAG(int, workers, 0, "Threads in the shared work-stealing pool executing APIs (0 uses one per core)");
+ABSL_FLAG(int, inline_threshold_us, 50, "Parameterless APIs averaging less than this many microseconds run on the I/O thread (0 disables)");
+ABSL_FLAG(int, upstream_connections, 16, "Max keep-alive connections per upstream host for <-");
+ABSL_FLAG(int, upstream_idle_timeout, 30, "Seconds an idle upstream connection is kept for reuse");
+ABSL_FLAG(int, upstream_timeout, 10, "Seconds allowed for each connect, request write and response read of <-");
+ABSL_FLAG(int, upstream_max_body_mb, 64, "Max body size in MiB of an <- response; larger responses fail (0 disables the limit)");
+ABSL_FLAG(int, upstream_cache_mb, 64, "Memory budget in MiB of the decoded values in the <- response cache, shared by all entries; a response that decodes to more is not cached (0 disables the cache)");
+ABSL_FLAG(int, upstream_stats, 0, "Seconds between <- coalescing stats printed to stderr (0 disables them)");
+ABSL_FLAG(std::string, passes, "fold,branch,dce,hoist", "Comma-separated AST optimization passes to run");
 
 int main(int argc, char* argv[]) {
     // 解析命令行参数
     std::vector<char*> args = absl::ParseCommandLine(argc, argv);
 
+    Jit::instance().set_threshold(std::max(absl::GetFlag(FLAGS_jit_threshold), 0));
+    Listener::keep_alive_timeout = std::chrono::seconds(std::max(absl::GetFlag(FLAGS_keep_alive_timeout), 1));
+    Listener::max_keep_alive_requests = std::max(absl::GetFlag(FLAGS_keep_alive_requests), 1);
+    Listener::pipeline_depth = std::max(absl::GetFlag(FLAGS_pipeline_depth), 1);
+    Listener::inline_threshold = std::chrono::microseconds(std::max(absl::GetFlag(FLAGS_inline_threshold_us), 0));
+    const int cores = std::max<int>(std::thread::hardware_concurrency(), 1);
+    Listener::reactors = absl::GetFlag(FLAGS_reactors) > 0 ? absl::GetFlag(FLAGS_reactors) : cores;
+    WorkerPool::instance().start(absl::GetFlag(FLAGS_workers) > 0 ? absl::GetFlag(FLAGS_workers) : cores);
+    HttpClient::instance().configure(std::max(absl::GetFlag(FLAGS_upstream_connections), 1),
+                                     std::chrono::seconds(std::max(absl::GetFlag(FLAGS_upstream_idle_timeout), 0)),
+                                     std::chrono::seconds(std::max(absl::GetFlag(FLAGS_upstream_timeout), 1)),
+                                     uint64_t(std::max(absl::GetFlag(FLAGS_upstream_max_body_mb), 0)) << 20);
+    ResponseCache::instance().set_capacity(size_t(std::max(absl::GetFlag(FLAGS_upstream_cache_mb), 0)) << 20);
+
+    // 定期输出上游请求的合并率
+    if (int interval = absl::GetFlag(FLAGS_upstream_stats); interval > 0) {
+        std::thread([interval] {
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(interval));
+                std::cerr << Singleflight::instance().report() << std::endl;
+            }
+        }).detach();
+    }
+
+    // --output 生成的可执行文件：直接加载附带的字节码和本地代码
+    std::unique_ptr<Image> image;
+    try {
+        image = load_embedded_image();
+    } catch (const ImageError& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (image) {
+        Jit::instance().load_object(image->object, image->symbols, *image->module);
+        try {
+            executor.execute(image->program, image->module);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // 检查源文件参数是否存在
     if (args.size() != 2) {
         std::cerr << "Usage: " << args[0] << " [--debug] [--eval] [--output=filename] <source_file>" << std::endl;
@@ -53,7 +109,7 @@ int main(int argc, char* argv[]) {
             auto const address = net::ip::make_address("0.0.0.0");
             auto const endpoint = tcp::endpoint{address, static_cast<unsigned short>(port)};
             std::unordered_map<std::string, std::unique_ptr<APINode>> apis;
-            auto listener = std::make_shared<Listener>(ioc, endpoint, std::move(apis));
+            auto listener = std::make_shared<Listener>(ioc, endpoint, apis);
             listener->run();  // 启动监听器
             ioc.run();
         }
@@ -73,16 +129,56 @@ int main(int argc, char* argv[]) {
     Parser parser(lexer);
     std::unique_ptr<ProgramNode> program = parser.parse_program();
 
-    // 调试模式下输出AST
+    // AST 优化（预构建的常量与全局值一样存活于整个进程）
+    Optimizer optimizer;
+    std::vector<std::string> passes = absl::StrSplit(absl::GetFlag(FLAGS_passes), ',', absl::SkipEmpty());
+    if (!optimizer.select(passes)) {
+        std::cerr << "Unknown optimization pass in --passes=" << absl::GetFlag(FLAGS_passes) << std::endl;
+        return 1;
+    }
+    optimizer.run(*program, Arena::global());
+
+    // 编译为字节码（api 的路径模板在这里解析）
+    std::shared_ptr<Module> module;
+    try {
+        module = Compiler().compile(*program);
+    } catch (const RouterError& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // 调试模式下输出AST、优化统计和字节码，响应体使用缩进格式
     if (debug_mode) {
+        Listener::response_indent = 4;
         std::cout << "Successfully parsed the program!\n" << std::endl;
         std::cout << "Abstract Syntax Tree:\n" << std::endl;
         std::cout << program->to_string(4) << std::endl;
         std::cout << std::endl;
+        std::cout << "Optimizations:\n" << std::endl;
+        std::cout << optimizer.report(4) << std::endl;
+        std::cout << "Bytecode:\n" << std::endl;
+        std::cout << module->to_string(4) << std::endl;
+    }
+
+    // 生成独立的可执行文件，不执行
+    if (!output_file.empty()) {
+        try {
+            write_executable(output_file, *program, *module);
+        } catch (const ImageError& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << output_file << std::endl;
+        return 0;
     }
 
-    // 编译并运行
-    executor.execute(program);
+    // 执行（同一端口上的路径模板冲突、init 出错时报错，例如 init 中的 <- 请求失败）
+    try {
+        executor.execute(program, module);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }
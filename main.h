@@ -6,6 +6,7 @@
 #define MAIN_H
 #include <string>
 
+// 编译并执行 input（eval 模式），返回 print 的输出或错误信息
 std::string eval(const std::string& input);
 
 #endif //MAIN_H
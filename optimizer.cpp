@@ -0,0 +1,350 @@
+//
+// Created by ezzno on 2025/9/17.
+//
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "executor.h"
+#include "optimizer.h"
+
+void Optimizer::Pass::run(ProgramNode& program, Arena& arena) {
+    program_ = &program;
+    arena_ = &arena;
+
+    for (auto& [name, func] : program.functions) {
+        visit(func->body);
+    }
+    for (auto& api : program.apis) {
+        visit(api->body);
+    }
+
+    program_ = nullptr;
+    arena_ = nullptr;
+}
+
+void Optimizer::Pass::visit(std::unique_ptr<StmtNode>& stmt) {
+    if (!stmt) {
+        return;
+    }
+
+    // each 的 expr 只记录参数名和数组名，没有可优化的子表达式
+    if (stmt->stmt_type != StmtNode::StmtType::EACH) {
+        visit(stmt->expr);
+    }
+    visit(stmt->condition);
+    for (auto& expr : stmt->exprs) {
+        visit(expr);
+    }
+    for (auto& child : stmt->children) {
+        visit(child);
+    }
+}
+
+void Optimizer::Pass::visit(std::unique_ptr<ExprNode>& expr) {
+    if (!expr) {
+        return;
+    }
+
+    visit(expr->left);
+    visit(expr->right);
+    for (auto& elem : expr->array_elements) {
+        visit(elem);
+    }
+    for (auto& [key, value] : expr->object_members) {
+        visit(value);
+    }
+}
+
+bool Optimizer::Pass::is_constant(const ExprNode* expr) const {
+    if (!expr || expr->constant < 0) {
+        return false;
+    }
+    switch (expr->op_type) {
+        case ExprNode::OpType::CONSTANT_INT:
+        case ExprNode::OpType::CONSTANT_FLOAT:
+        case ExprNode::OpType::CONSTANT_STRING:
+        case ExprNode::OpType::CONSTANT_VALUE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const Value& Optimizer::Pass::constant_of(const ExprNode* expr) const {
+    return program_->constants[expr->constant];
+}
+
+std::unique_ptr<ExprNode> Optimizer::Pass::make_constant(Value value) {
+    json j;
+    to_json(j, value);
+
+    auto node = std::make_unique<ExprNode>(ExprNode::OpType::CONSTANT_VALUE, j.dump());
+    node->constant = static_cast<int>(program_->constants.size());
+    program_->constants.push_back(std::move(value));
+    return node;
+}
+
+namespace {
+
+// 常量折叠：操作数均为常量的算术、比较、逻辑运算在编译前求值
+// 运行时会报错的表达式（除零、类型不匹配）保持原样
+class FoldPass final : public Optimizer::Pass {
+protected:
+    void visit(std::unique_ptr<ExprNode>& expr) override {
+        Pass::visit(expr);
+        if (!expr) {
+            return;
+        }
+
+        static const std::unordered_map<ExprNode::OpType, OpCode> binary_ops = {
+            {ExprNode::OpType::ADD, OpCode::ADD}, {ExprNode::OpType::SUB, OpCode::SUB},
+            {ExprNode::OpType::MUL, OpCode::MUL}, {ExprNode::OpType::DIV, OpCode::DIV},
+            {ExprNode::OpType::EQ, OpCode::EQ}, {ExprNode::OpType::NEQ, OpCode::NEQ},
+            {ExprNode::OpType::LT, OpCode::LT}, {ExprNode::OpType::GT, OpCode::GT},
+            {ExprNode::OpType::LE, OpCode::LE}, {ExprNode::OpType::GE, OpCode::GE},
+            {ExprNode::OpType::AND, OpCode::AND}, {ExprNode::OpType::OR, OpCode::OR},
+        };
+
+        if (expr->op_type == ExprNode::OpType::NOT) {
+            const ExprNode* operand = expr->right ? expr->right.get() : expr->left.get();
+            if (is_constant(operand) && constant_of(operand).is_bool()) {
+                expr = make_constant(!constant_of(operand).as_bool());
+                ++changes;
+            }
+            return;
+        }
+
+        auto op = binary_ops.find(expr->op_type);
+        if (op == binary_ops.end() || !is_constant(expr->left.get()) || !is_constant(expr->right.get())) {
+            return;
+        }
+
+        const Value& l = constant_of(expr->left.get());
+        const Value& r = constant_of(expr->right.get());
+        Value result;
+        try {
+            switch (op->second) {
+                case OpCode::ADD:
+                case OpCode::SUB:
+                case OpCode::MUL:
+                case OpCode::DIV:
+                    result = arithmetic(op->second, l, r, *arena_);
+                    break;
+                case OpCode::EQ:
+                case OpCode::NEQ:
+                    // 数组、对象按地址比较，编译期无法确定
+                    if (l.is_array() || l.is_object() || l.is_function() ||
+                        r.is_array() || r.is_object() || r.is_function()) {
+                        return;
+                    }
+                    result = (l == r) == (op->second == OpCode::EQ);
+                    break;
+                case OpCode::AND:
+                case OpCode::OR:
+                    if (!l.is_bool() || !r.is_bool()) {
+                        return;
+                    }
+                    result = op->second == OpCode::AND ? (l.as_bool() && r.as_bool())
+                                                       : (l.as_bool() || r.as_bool());
+                    break;
+                default:
+                    result = compare(op->second, l, r);
+                    break;
+            }
+        } catch (const ExecutionError&) {
+            return;
+        }
+
+        expr = make_constant(std::move(result));
+        ++changes;
+    }
+
+public:
+    [[nodiscard]] const char* name() const override { return "fold"; }
+    [[nodiscard]] const char* description() const override { return "constant expressions folded"; }
+};
+
+// 常量条件：if 只保留会执行的分支，while/for 条件恒不成立时删除循环
+class BranchPass final : public Optimizer::Pass {
+protected:
+    void visit(std::unique_ptr<StmtNode>& stmt) override {
+        Pass::visit(stmt);
+        if (!stmt || !is_constant(stmt->condition.get())) {
+            return;
+        }
+
+        const Value& cond = constant_of(stmt->condition.get());
+        switch (stmt->stmt_type) {
+            case StmtNode::StmtType::IF: {
+                // 非 bool 条件在运行时报错，保持原样
+                if (!cond.is_bool()) {
+                    return;
+                }
+                size_t branch = cond.as_bool() ? 0 : 1;
+                std::unique_ptr<StmtNode> taken;
+                if (branch < stmt->children.size()) {
+                    taken = std::move(stmt->children[branch]);
+                }
+                stmt = taken ? std::move(taken) : std::make_unique<StmtNode>(StmtNode::StmtType::EMPTY);
+                ++changes;
+                break;
+            }
+            case StmtNode::StmtType::WHILE:
+                // 循环条件非 bool 时视为 false
+                if (cond.is_bool() && cond.as_bool()) {
+                    return;
+                }
+                stmt = std::make_unique<StmtNode>(StmtNode::StmtType::EMPTY);
+                ++changes;
+                break;
+            case StmtNode::StmtType::FOR: {
+                if (cond.is_bool() && cond.as_bool()) {
+                    return;
+                }
+                // 初始化语句仍会执行
+                auto init = std::move(stmt->children[0]);
+                stmt = init ? std::move(init) : std::make_unique<StmtNode>(StmtNode::StmtType::EMPTY);
+                ++changes;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+public:
+    [[nodiscard]] const char* name() const override { return "branch"; }
+    [[nodiscard]] const char* description() const override { return "constant conditions removed"; }
+};
+
+// 死代码：代码块中必然返回的语句（return，或各分支都返回的 if / 代码块）之后的语句
+class DeadCodePass final : public Optimizer::Pass {
+private:
+    static bool always_returns(const StmtNode* stmt) {
+        if (!stmt) {
+            return false;
+        }
+        switch (stmt->stmt_type) {
+            case StmtNode::StmtType::RETURN:
+                return true;
+            case StmtNode::StmtType::BLOCK:
+                return std::any_of(stmt->children.begin(), stmt->children.end(), [](const auto& child) {
+                    return always_returns(child.get());
+                });
+            case StmtNode::StmtType::IF:
+                return stmt->children.size() >= 2 &&
+                       always_returns(stmt->children[0].get()) && always_returns(stmt->children[1].get());
+            default:
+                return false;
+        }
+    }
+
+protected:
+    void visit(std::unique_ptr<StmtNode>& stmt) override {
+        Pass::visit(stmt);
+        if (!stmt || stmt->stmt_type != StmtNode::StmtType::BLOCK) {
+            return;
+        }
+
+        auto& children = stmt->children;
+        auto ret = std::find_if(children.begin(), children.end(), [](const auto& child) {
+            return always_returns(child.get());
+        });
+        if (ret != children.end() && ret + 1 != children.end()) {
+            changes += static_cast<int>(children.end() - (ret + 1));
+            children.erase(ret + 1, children.end());
+        }
+    }
+
+public:
+    [[nodiscard]] const char* name() const override { return "dce"; }
+    [[nodiscard]] const char* description() const override { return "unreachable statements removed"; }
+};
+
+// 字面量提升：元素全为常量的数组、对象字面量预先构建，运行时直接引用（不可修改，请求间共享）
+class HoistPass final : public Optimizer::Pass {
+protected:
+    void visit(std::unique_ptr<ExprNode>& expr) override {
+        Pass::visit(expr);
+        if (!expr) {
+            return;
+        }
+
+        if (expr->op_type == ExprNode::OpType::ARRAY_LITERAL) {
+            Values array;
+            for (const auto& elem : expr->array_elements) {
+                if (!is_constant(elem.get())) {
+                    return;
+                }
+                array.push_back(constant_of(elem.get()));
+            }
+            expr = make_constant(arena_->make_array(std::move(array)));
+            ++changes;
+        } else if (expr->op_type == ExprNode::OpType::OBJECT_LITERAL) {
+            ValueMap object;
+            for (const auto& [key, value] : expr->object_members) {
+                if (!is_constant(value.get())) {
+                    return;
+                }
+                object[std::pmr::string(key)] = constant_of(value.get());
+            }
+            expr = make_constant(arena_->make_object(std::move(object)));
+            ++changes;
+        }
+    }
+
+public:
+    [[nodiscard]] const char* name() const override { return "hoist"; }
+    [[nodiscard]] const char* description() const override { return "constant literals prebuilt"; }
+};
+
+} // namespace
+
+Optimizer::Optimizer() {
+    passes_.push_back({std::make_unique<FoldPass>()});
+    passes_.push_back({std::make_unique<BranchPass>()});
+    passes_.push_back({std::make_unique<DeadCodePass>()});
+    passes_.push_back({std::make_unique<HoistPass>()});
+}
+
+bool Optimizer::select(const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        bool known = std::any_of(passes_.begin(), passes_.end(), [&](const Entry& entry) {
+            return name == entry.pass->name();
+        });
+        if (!known) {
+            return false;
+        }
+    }
+
+    for (auto& entry : passes_) {
+        entry.enabled = std::find(names.begin(), names.end(), entry.pass->name()) != names.end();
+    }
+    return true;
+}
+
+void Optimizer::run(ProgramNode& program, Arena& arena) {
+    for (auto& entry : passes_) {
+        if (entry.enabled) {
+            entry.pass->run(program, arena);
+        }
+    }
+}
+
+std::string Optimizer::report(int indent) const {
+    std::string ind(indent, ' ');
+    std::string result;
+
+    for (const auto& entry : passes_) {
+        result += ind + entry.pass->name() + ": ";
+        if (entry.enabled) {
+            result += std::to_string(entry.pass->changes) + " " + entry.pass->description();
+        } else {
+            result += "disabled";
+        }
+        result += "\n";
+    }
+
+    return result;
+}
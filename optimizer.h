@@ -0,0 +1,69 @@
+//
+// Created by ezzno on 2025/9/17.
+//
+
+#ifndef GLUE_OPTIMIZER_H
+#define GLUE_OPTIMIZER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "parser.h"
+
+// AST 优化器：在编译为字节码之前对整个程序做等价变换
+// 由若干可单独开关的 pass 组成，每个 pass 统计自己的修改次数（--debug 时输出）
+class Optimizer {
+public:
+    // 单个优化 pass
+    class Pass {
+    protected:
+        ProgramNode* program_ = nullptr;
+        Arena* arena_ = nullptr;
+
+        // 默认遍历：先处理子节点；子类重写时可在前后做变换
+        virtual void visit(std::unique_ptr<StmtNode>& stmt);
+        virtual void visit(std::unique_ptr<ExprNode>& expr);
+
+        // 常量节点（字面量或此前的优化结果）及其值
+        [[nodiscard]] bool is_constant(const ExprNode* expr) const;
+        [[nodiscard]] const Value& constant_of(const ExprNode* expr) const;
+
+        // 生成引用常量池中 value 的节点
+        std::unique_ptr<ExprNode> make_constant(Value value);
+
+    public:
+        int changes = 0;
+
+        virtual ~Pass() = default;
+
+        [[nodiscard]] virtual const char* name() const = 0;
+        [[nodiscard]] virtual const char* description() const = 0;
+
+        // 对所有函数和 api 执行；新建的数组、对象分配在 arena 中
+        void run(ProgramNode& program, Arena& arena);
+    };
+
+private:
+    struct Entry {
+        std::unique_ptr<Pass> pass;
+        bool enabled = true;
+    };
+
+    // 按执行顺序排列
+    std::vector<Entry> passes_;
+
+public:
+    Optimizer();
+
+    // 只启用 names 中列出的 pass，存在未知名称时返回 false
+    bool select(const std::vector<std::string>& names);
+
+    void run(ProgramNode& program, Arena& arena);
+
+    // 各 pass 的修改次数
+    [[nodiscard]] std::string report(int indent = 0) const;
+};
+
+#endif // GLUE_OPTIMIZER_H
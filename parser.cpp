@@ -5,6 +5,7 @@
 #include <iostream>
 #include <execinfo.h>  // 非标准库，但但在Linux/macOS上普遍存在
 
+#include "arena.h"
 #include "namespace.h"
 #include "parser.h"
 
@@ -40,6 +41,30 @@ static void print_backtrace() {
     free(frame_symbols);  // 释放动态分配的内存
 }
 
+int Parser::add_literal() {
+    auto key = std::make_pair(current_token.type, current_token.value);
+    auto it = literals_.find(key);
+    if (it != literals_.end()) {
+        return it->second;
+    }
+
+    Value value;
+    try {
+        switch (current_token.type) {
+            case CONSTANT_INTEGER: value = std::stoi(current_token.value); break;
+            case CONSTANT_FLOAT: value = std::stof(current_token.value); break;
+            default: value = strings_->intern(current_token.value); break;
+        }
+    } catch (const std::logic_error&) {
+        error("Invalid numeric literal");
+    }
+
+    int index = static_cast<int>(constants_.size());
+    constants_.push_back(std::move(value));
+    literals_.emplace(std::move(key), index);
+    return index;
+}
+
 void Parser::error(const std::string& message) const {
     std::ostringstream oss;
     oss << "Parse error at line " << current_token.line
@@ -203,6 +228,12 @@ std::unique_ptr<ExprNode> Parser::parse_curl_expression() {
         op->left = std::move(left);
         consume();
         op->right = parse_primary_expression();
+
+        // 可选的缓存时长（秒）：x <- url cache 60，0 表示不使用缓存
+        if (current_token.type == IDENTIFIER && current_token.value == "cache") {
+            consume();
+            op->array_elements.push_back(parse_primary_expression());
+        }
         left = std::move(op);
     }
 
@@ -228,6 +259,9 @@ std::unique_ptr<ExprNode> Parser::parse_address_expression() {
                 error("Expected int or string");
             }
             auto node = std::make_unique<ExprNode>(ExprNode::OpType::DOT, current_token.value, current_token.type);
+            if (current_token.type == CONSTANT_INTEGER) {
+                node->constant = add_literal();
+            }
             consume();
 
             return node;
@@ -261,16 +295,19 @@ std::unique_ptr<ExprNode> Parser::parse_primary_expression() {
     switch (current_token.type) {
         case CONSTANT_INTEGER: {
             auto node = std::make_unique<ExprNode>(ExprNode::OpType::CONSTANT_INT, current_token.value);
+            node->constant = add_literal();
             consume();
             return node;
         }
         case CONSTANT_FLOAT: {
             auto node = std::make_unique<ExprNode>(ExprNode::OpType::CONSTANT_FLOAT, current_token.value);
+            node->constant = add_literal();
             consume();
             return node;
         }
         case CONSTANT_STRING: {
             auto node = std::make_unique<ExprNode>(ExprNode::OpType::CONSTANT_STRING, current_token.value);
+            node->constant = add_literal();
             consume();
             return node;
         }
@@ -469,11 +506,12 @@ std::unique_ptr<StmtNode> Parser::parse_for_statement() {
     expect(KEYWORD_FOR, "Expected 'for'");
     expect(SEPARATOR_LPAREN, "Expected '(' after 'for'");
 
-    // 初始化部分
+    // 初始化部分（缺省时用空语句占位，保证 children 固定为 初始化、迭代、循环体）
     if (current_token.type != SEPARATOR_SEMICOLON) {
         for_stmt->children.push_back(parse_statement());
     } else {
         consume(); // 跳过;
+        for_stmt->children.push_back(std::make_unique<StmtNode>(StmtNode::StmtType::EMPTY));
     }
 
     // 条件部分
@@ -487,6 +525,8 @@ std::unique_ptr<StmtNode> Parser::parse_for_statement() {
         auto update_stmt = std::make_unique<StmtNode>(StmtNode::StmtType::EXPRESSION);
         update_stmt->expr = parse_expression();
         for_stmt->children.push_back(std::move(update_stmt));
+    } else {
+        for_stmt->children.push_back(std::make_unique<StmtNode>(StmtNode::StmtType::EMPTY));
     }
 
     expect(SEPARATOR_RPAREN, "Expected ')' after for loop conditions");
@@ -607,6 +647,44 @@ Parameters Parser::parse_parameters() {
     return params;
 }
 
+void Parser::assigned_names(const StmtNode* stmt, std::vector<std::string>& names) {
+    if (!stmt) {
+        return;
+    }
+
+    if (stmt->stmt_type == StmtNode::StmtType::EACH && stmt->expr) {
+        names.insert(names.end(), stmt->expr->parameters.begin(), stmt->expr->parameters.end());
+    } else {
+        assigned_names(stmt->expr.get(), names);
+    }
+    assigned_names(stmt->condition.get(), names);
+    for (const auto& expr : stmt->exprs) {
+        assigned_names(expr.get(), names);
+    }
+    for (const auto& child : stmt->children) {
+        assigned_names(child.get(), names);
+    }
+}
+
+void Parser::assigned_names(const ExprNode* expr, std::vector<std::string>& names) {
+    if (!expr) {
+        return;
+    }
+
+    if ((expr->op_type == ExprNode::OpType::ASSIGN || expr->op_type == ExprNode::OpType::CURL) &&
+        expr->left && expr->left->op_type == ExprNode::OpType::IDENTIFIER) {
+        names.push_back(expr->left->value);
+    }
+    assigned_names(expr->left.get(), names);
+    assigned_names(expr->right.get(), names);
+    for (const auto& elem : expr->array_elements) {
+        assigned_names(elem.get(), names);
+    }
+    for (const auto& [key, value] : expr->object_members) {
+        assigned_names(value.get(), names);
+    }
+}
+
 std::unique_ptr<FuncNode> Parser::parse_function() {
     // function name
     if (current_token.type != IDENTIFIER) {
@@ -624,6 +702,7 @@ std::unique_ptr<FuncNode> Parser::parse_function() {
     auto func = std::make_unique<FuncNode>("", func_name);
     func->parameters = std::move(params);
     func->body = parse_block();
+    assigned_names(func->body.get(), func->assigned);
 
     return func;
 }
@@ -647,6 +726,7 @@ std::unique_ptr<ProgramNode> Parser::parse_program() {
                 // 函数体
                 auto api = std::make_unique<APINode>(api_path);
                 api->body = parse_block();
+                assigned_names(api->body.get(), api->assigned);
                 api->port = port;
 
                 program->apis.push_back(std::move(api));
@@ -672,5 +752,7 @@ std::unique_ptr<ProgramNode> Parser::parse_program() {
         }
     }
 
+    program->constants = std::move(constants_);
+    program->strings = strings_;
     return program;
 }
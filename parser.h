@@ -5,7 +5,10 @@
 #ifndef GLUE_PARSER_H
 #define GLUE_PARSER_H
 
+#include "arena.h"
 #include "lexer.h"
+#include "value.h"
+#include <map>
 #include <utility>
 #include <vector>
 #include <string>
@@ -28,6 +31,7 @@ public:
         EQ, NEQ, LT, GT, LE, GE,
         AND, OR, NOT,
         CONSTANT_INT, CONSTANT_FLOAT, CONSTANT_STRING,
+        CONSTANT_VALUE,   // 优化器生成的常量（折叠结果、预构建的数组/对象）
         IDENTIFIER,
         ARRAY_LITERAL, ARRAY_ACCESS,
         OBJECT_LITERAL,   // 对象字面量 {"xx": xxx}
@@ -35,12 +39,13 @@ public:
         IN,
         ASSIGN,
         DOT,
-        CURL,
+        CURL,             // left <- right，array_elements 中为可选的缓存时长
     };
 
     TokenType token_type;
     OpType op_type;
     std::string value;  // 用于存储常量值或标识符名称
+    int constant = -1;  // 字面量（含 .1 形式的下标）在程序常量池中的位置
     std::unique_ptr<ExprNode> left;
     std::unique_ptr<ExprNode> right;
 
@@ -82,6 +87,9 @@ public:
     Parameters parameters;  // type, name
     std::unique_ptr<StmtNode> body;
 
+    // 函数体内被赋值的名称（局部变量），在解析时扫描，不受之后的优化影响
+    std::vector<std::string> assigned;
+
     FuncNode(std::string ret_type, std::string func_name)
         : return_type(std::move(ret_type)), name(std::move(func_name)) {}
 
@@ -95,6 +103,9 @@ public:
     int port;
     std::unique_ptr<StmtNode> body;
 
+    // 同 FuncNode::assigned
+    std::vector<std::string> assigned;
+
     APINode(std::string path)
         : path(std::move(path)) {}
 
@@ -107,6 +118,12 @@ public:
     std::unordered_map<std::string, std::unique_ptr<FuncNode>> functions;
     std::vector<std::unique_ptr<APINode>> apis;
 
+    // 常量池：解析时解码一次的字面量（相同字面量共用一项）
+    Values constants;
+
+    // 常量池中的字符串，与编译出的 Module 共享
+    std::shared_ptr<StringPool> strings;
+
     [[nodiscard]] std::string to_string(int indent = 0) const override;
 };
 
@@ -116,6 +133,14 @@ private:
     Lexer& lexer;
     Token current_token;
 
+    // 常量池及其去重索引
+    Values constants_;
+    std::shared_ptr<StringPool> strings_ = std::make_shared<StringPool>();
+    std::map<std::pair<TokenType, std::string>, int> literals_;
+
+    // 解码当前字面量令牌并加入常量池，返回其下标
+    int add_literal();
+
     // 辅助函数：消费当前令牌并获取下一个
     void consume();
 
@@ -151,6 +176,10 @@ private:
     std::unique_ptr<StmtNode> parse_print_statement();
     std::unique_ptr<StmtNode> parse_declaration();
 
+    // 函数体内被赋值的名称（含 each 的循环变量），按首次出现的顺序
+    static void assigned_names(const StmtNode* stmt, std::vector<std::string>& names);
+    static void assigned_names(const ExprNode* expr, std::vector<std::string>& names);
+
     // 函数解析
     std::unique_ptr<FuncNode> parse_function();
     Parameters parse_parameters();
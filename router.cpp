@@ -0,0 +1,270 @@
+//
+// Created by ezzno on 2025/9/25.
+//
+
+#include <algorithm>
+
+#include "router.h"
+
+namespace {
+
+// 路径模板切分出的一段：静态路径、:name 或 *name
+struct Segment {
+    enum class Kind { STATIC, PARAM, WILDCARD } kind;
+    std::string text;  // 静态路径或参数名
+};
+
+// 解析路径模板，query 中返回声明的查询参数名
+std::vector<Segment> parse(const std::string& pattern, std::vector<std::string>& query) {
+    std::string_view view(pattern);
+    auto question = view.find('?');
+    std::string_view path = view.substr(0, question);
+    if (path.empty() || path[0] != '/') {
+        throw RouterError("api path must start with '/': " + pattern);
+    }
+
+    std::vector<Segment> segments;
+    std::vector<std::string> names;
+    std::string text;
+    size_t pos = 0;
+    while (pos < path.size()) {
+        char c = path[pos];
+        // 只有整段以 : 或 * 开头时才是参数，其余位置的 : 和 * 是普通字符
+        if ((c != ':' && c != '*') || path[pos - 1] != '/') {
+            text += c;
+            ++pos;
+            continue;
+        }
+
+        size_t end = std::min(path.find('/', pos), path.size());
+        std::string name(path.substr(pos + 1, end - pos - 1));
+        if (name.empty()) {
+            throw RouterError("empty parameter name in api path: " + pattern);
+        }
+        if (c == '*' && end != path.size()) {
+            throw RouterError("*" + name + " must be the last segment of api path: " + pattern);
+        }
+        if (!text.empty()) {
+            segments.push_back({Segment::Kind::STATIC, std::move(text)});
+            text.clear();
+        }
+        segments.push_back({c == ':' ? Segment::Kind::PARAM : Segment::Kind::WILDCARD, name});
+        names.push_back(std::move(name));
+        pos = end;
+    }
+    if (!text.empty()) {
+        segments.push_back({Segment::Kind::STATIC, std::move(text)});
+    }
+
+    query.clear();
+    if (question != std::string_view::npos) {
+        std::string_view rest = view.substr(question + 1);
+        while (true) {
+            auto amp = rest.find('&');
+            std::string name(rest.substr(0, amp));
+            if (name.empty()) {
+                throw RouterError("empty query parameter name in api path: " + pattern);
+            }
+            query.push_back(name);
+            names.push_back(std::move(name));
+            if (amp == std::string_view::npos) {
+                break;
+            }
+            rest = rest.substr(amp + 1);
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    auto duplicate = std::adjacent_find(names.begin(), names.end());
+    if (duplicate != names.end()) {
+        throw RouterError("duplicate parameter " + *duplicate + " in api path: " + pattern);
+    }
+    return segments;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} // namespace
+
+Router::Node* Router::insert(Node* node, std::string_view path) {
+    while (!path.empty()) {
+        auto index = node->indices.find(path[0]);
+        if (index == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = path;
+            node->indices.push_back(path[0]);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        // 公共前缀短于已有的边时，在公共前缀处拆分出中间节点
+        auto& child = node->children[index];
+        size_t common = 0;
+        while (common < child->prefix.size() && common < path.size() && child->prefix[common] == path[common]) {
+            ++common;
+        }
+        if (common < child->prefix.size()) {
+            auto middle = std::make_unique<Node>();
+            middle->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            middle->indices.push_back(child->prefix[0]);
+            middle->children.push_back(std::move(child));
+            child = std::move(middle);
+        }
+        node = child.get();
+        path.remove_prefix(common);
+    }
+    return node;
+}
+
+void Router::add(const std::string& pattern, const APINode* api) {
+    auto route = std::make_unique<Route>(Route{pattern, api, 0, {}});
+    Node* node = &root_;
+    for (const auto& segment : parse(pattern, route->query)) {
+        switch (segment.kind) {
+            case Segment::Kind::STATIC:
+                node = insert(node, segment.text);
+                break;
+            case Segment::Kind::PARAM:
+                if (!node->param) {
+                    node->param = std::make_unique<Node>();
+                }
+                node = node->param.get();
+                ++route->path_parameters;
+                break;
+            case Segment::Kind::WILDCARD:
+                if (!node->wildcard) {
+                    node->wildcard = std::make_unique<Node>();
+                }
+                node = node->wildcard.get();
+                ++route->path_parameters;
+                break;
+        }
+    }
+
+    // 只有参数名不同的模板匹配相同的路径
+    if (node->route) {
+        throw RouterError("api path " + pattern + " conflicts with " + node->route->pattern);
+    }
+    node->route = route.get();
+    routes_.push_back(std::move(route));
+}
+
+const Router::Route* Router::find(const Node& node, std::string_view path, Match& match) {
+    if (path.empty() && node.route) {
+        return node.route;
+    }
+
+    if (!path.empty()) {
+        auto index = node.indices.find(path[0]);
+        if (index != std::string::npos) {
+            const Node& child = *node.children[index];
+            if (path.starts_with(child.prefix)) {
+                if (auto route = find(child, path.substr(child.prefix.size()), match)) {
+                    return route;
+                }
+            }
+        }
+
+        if (node.param) {
+            auto segment = path.substr(0, path.find('/'));
+            if (!segment.empty()) {
+                match.arguments.emplace_back(segment);
+                if (auto route = find(*node.param, path.substr(segment.size()), match)) {
+                    return route;
+                }
+                match.arguments.pop_back();
+            }
+        }
+    }
+
+    if (node.wildcard) {
+        match.arguments.emplace_back(path);
+        return node.wildcard->route;
+    }
+    return nullptr;
+}
+
+bool Router::match(std::string_view target, Match& match) const {
+    auto question = target.find('?');
+    if (question == std::string_view::npos) {
+        return this->match(target, {}, match);
+    }
+    return this->match(target.substr(0, question), target.substr(question + 1), match);
+}
+
+bool Router::match(std::string_view path, std::string_view query, Match& match) const {
+    match.api = nullptr;
+    match.arguments.clear();
+    const Route* route = find(root_, path, match);
+    if (!route) {
+        return false;
+    }
+
+    match.api = route->api;
+    match.path_arguments = match.arguments.size();
+    match.arguments.resize(match.path_arguments + route->query.size());
+    if (route->query.empty()) {
+        return true;
+    }
+
+    // 按声明的名称取查询参数，同名的参数取第一个，未声明的忽略
+    while (!query.empty()) {
+        auto amp = query.find('&');
+        auto pair = query.substr(0, amp);
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+
+        auto eq = pair.find('=');
+        auto key = pair.substr(0, eq);
+        auto value = eq == std::string_view::npos ? pair.substr(pair.size()) : pair.substr(eq + 1);
+        for (size_t i = 0; i < route->query.size(); ++i) {
+            auto& argument = match.arguments[match.path_arguments + i];
+            if (route->query[i] == key && !argument) {
+                argument = value;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+Parameters Router::parameters(const std::string& pattern) {
+    std::vector<std::string> query;
+    Parameters parameters;
+    for (auto& segment : parse(pattern, query)) {
+        if (segment.kind != Segment::Kind::STATIC) {
+            parameters.push_back(std::move(segment.text));
+        }
+    }
+    parameters.insert(parameters.end(), query.begin(), query.end());
+    return parameters;
+}
+
+std::string Router::decode(std::string_view value, bool query) {
+    std::string decoded;
+    decoded.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (c == '%' && i + 2 < value.size() && hex_value(value[i + 1]) >= 0 && hex_value(value[i + 2]) >= 0) {
+            decoded += static_cast<char>(hex_value(value[i + 1]) * 16 + hex_value(value[i + 2]));
+            i += 2;
+        } else if (c == '+' && query) {
+            decoded += ' ';
+        } else {
+            // 无效的转义按原样保留
+            decoded += c;
+        }
+    }
+    return decoded;
+}
@@ -0,0 +1,81 @@
+//
+// Created by ezzno on 2025/9/25.
+//
+
+#ifndef GLUE_ROUTER_H
+#define GLUE_ROUTER_H
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parser.h"
+
+// api 路由：按路径模板匹配请求目标，启动时构建，之后只读，可在线程间共享
+// 路径模板由 '/' 分隔的段组成，:name 匹配一个非空的段，*name 匹配剩余的路径（可以为空，只能在末尾）
+// 模板末尾可以用 ?a&b 声明查询参数；路径参数（按出现顺序）和查询参数依次作为 api 的参数
+// 静态部分压缩为基数树的边，匹配时依次尝试静态边、:name、*name，耗时只取决于路径长度，与路由数量无关
+class Router {
+public:
+    // 一次匹配的结果：参数值是请求目标的视图（未解码），请求中没有的查询参数为空
+    struct Match {
+        const APINode* api = nullptr;
+        size_t path_arguments = 0;
+        std::vector<std::optional<std::string_view>> arguments;
+    };
+
+private:
+    struct Route {
+        std::string pattern;
+        const APINode* api;
+        size_t path_parameters;
+        std::vector<std::string> query;  // 声明的查询参数名
+    };
+
+    struct Node {
+        std::string prefix;                           // 从父节点到这里的静态路径（:name、*name 节点为空）
+        std::string indices;                          // 各静态子节点 prefix 的首字符
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> param;                  // :name
+        std::unique_ptr<Node> wildcard;               // *name，总是叶子
+        const Route* route = nullptr;                 // 在这里结束的路由
+    };
+
+    Node root_;
+    std::vector<std::unique_ptr<Route>> routes_;
+
+    // 插入静态路径，返回其末端的节点（必要时拆分已有的边）
+    static Node* insert(Node* node, std::string_view path);
+
+    // 匹配 node 之后剩余的路径，路径参数依次追加到 arguments
+    static const Route* find(const Node& node, std::string_view path, Match& match);
+
+public:
+    // 添加路由，模板无效或与已有路由冲突时抛出 RouterError
+    void add(const std::string& pattern, const APINode* api);
+
+    // 匹配请求目标（路径与查询串），找不到时返回 false
+    bool match(std::string_view target, Match& match) const;
+    bool match(std::string_view path, std::string_view query, Match& match) const;
+
+    [[nodiscard]] bool empty() const {
+        return routes_.empty();
+    }
+
+    // 模板声明的参数名：路径参数在前，其后是查询参数；模板无效时抛出 RouterError
+    static Parameters parameters(const std::string& pattern);
+
+    // 百分号解码，query 为 true 时 '+' 解码为空格
+    static std::string decode(std::string_view value, bool query);
+};
+
+// 路径模板无效或冲突
+class RouterError final : public std::runtime_error {
+public:
+    explicit RouterError(const std::string& message) : std::runtime_error(message) {}
+};
+
+#endif // GLUE_ROUTER_H
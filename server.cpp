@@ -3,12 +3,17 @@
 //
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
 
 #include "server.h"
 #include "executor.h"
+#include "singleflight.h"
+#include "workers.h"
 #include "main.h"
 
 namespace beast = boost::beast;         // from <boost/beast.hpp>
@@ -16,92 +21,293 @@ namespace http = beast::http;           // from <boost/beast/http.hpp>
 namespace net = boost::asio;            // from <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
 
-// 处理单个HTTP请求并发送响应
+// 处理一个连接上的HTTP请求：客户端要求保持连接时在同一连接上循环读取请求、执行并写回响应
+// 流水线发来的请求提前读取、并发执行，响应按请求的顺序写回；连接的状态只在其 strand 上访问
 class Session : public std::enable_shared_from_this<Session>
 {
+    // 一次请求及其响应，写回后回收供下一个请求复用（保留 arena 已申请的内存）
+    struct Exchange {
+        http::request<http::string_body> req;
+        http::response<http::string_body> res;
+        const std::string* raw = nullptr;        // 常量 api 预先序列化的完整响应
+        const Function* function = nullptr;      // 执行的 api，执行完成后记录耗时
+        Router::Match route;                     // 匹配到的 api 及其参数（req 目标的视图）
+        bool ready = false;                      // 响应已生成，可以写回
+
+        // 执行中的 api：在 <- 处挂起时保存执行状态，本次请求新建的值分配在 arena 中
+        std::optional<Executor> exe;
+        Arena arena;
+    };
+
     tcp::socket socket_;
     beast::flat_buffer buffer_;
-    http::request<http::string_body> req_;
-    http::response<http::string_body> res_; // <--- 放在成员里
+    net::steady_timer idle_timer_;
     unsigned short port_;  // 记录当前连接的端口
-    const std::unordered_map<std::string, std::unique_ptr<APINode>>& apis_;
-    net::thread_pool& thread_pool_;
+    const Router& router_;  // 为空时是 eval 模式
+    const std::unordered_map<const APINode*, std::string>& responses_;
+
+    std::deque<std::shared_ptr<Exchange>> queue_;  // 已读取、尚未写回的请求，按到达顺序
+    std::vector<std::shared_ptr<Exchange>> spare_;
+    size_t served_ = 0;     // 已读取的请求数
+    bool reading_ = false;
+    bool writing_ = false;
+    bool closing_ = false;  // 不再读取新请求，写完队列中的响应后关闭
 
 public:
     // 构造函数，获取socket和端口号
     Session(tcp::socket socket, unsigned short port,
-        const std::unordered_map<std::string, std::unique_ptr<APINode>>& apis, net::thread_pool& thread_pool)
-        : socket_(std::move(socket)), port_(port), apis_(apis), thread_pool_(thread_pool) {}
+        const Router& router,
+        const std::unordered_map<const APINode*, std::string>& responses)
+        : socket_(std::move(socket)), idle_timer_(socket_.get_executor()), port_(port), router_(router), responses_(responses) {}
 
     // 开始处理会话
     void run()
     {
+        do_read();
+    }
+
+private:
+    // 读取下一个请求；排队的请求达到流水线深度时暂停，写回一个响应后继续
+    void do_read()
+    {
+        if (reading_ || closing_ || queue_.size() >= Listener::pipeline_depth) {
+            return;
+        }
+        reading_ = true;
+
+        std::shared_ptr<Exchange> exchange;
+        if (spare_.empty()) {
+            exchange = std::make_shared<Exchange>();
+        } else {
+            exchange = std::move(spare_.back());
+            spare_.pop_back();
+        }
+
         // 确保对象在操作完成前不会被销毁
         auto self(shared_from_this());
-
-        // 异步读取请求
-        http::async_read(socket_, buffer_, req_,
-            [self](beast::error_code ec, std::size_t bytes_transferred)
+        arm_idle_timer();
+        http::async_read(socket_, buffer_, exchange->req,
+            [self, exchange](beast::error_code ec, std::size_t bytes_transferred)
             {
                 boost::ignore_unused(bytes_transferred);
-                if(!ec)
-                    self->handle_request();
+                self->reading_ = false;
+                if (ec) {
+                    // 对端关闭、超时或请求无效：写完已读取的请求的响应后关闭
+                    self->closing_ = true;
+                    self->finish_if_idle();
+                    return;
+                }
+                self->handle_request(exchange);
             }
         );
     }
 
-private:
-    // 处理请求并发送响应
-    void handle_request()
+    // 处理请求：常量 api 直接使用预先序列化的响应，耗时短的在 I/O 线程上执行，其余在线程池中执行
+    void handle_request(const std::shared_ptr<Exchange>& exchange)
     {
         // 输出连接信息
-        // std::cout << "Received request on port " << port_ << " for " << req_.target() << std::endl;
+        // std::cout << "Received request on port " << port_ << " for " << exchange->req.target() << std::endl;
 
-        res_ = http::response<http::string_body>{http::status::ok, req_.version()};
-        res_.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res_.set(http::field::content_type, "application/json; charset=utf-8");
+        queue_.push_back(exchange);
+        if (!exchange->req.keep_alive() || ++served_ >= Listener::max_keep_alive_requests) {
+            closing_ = true;
+        }
 
-        auto self(shared_from_this());
+        // 按路径匹配 api，参数是请求目标的视图，在执行时解码
+        const APINode* api = nullptr;
+        auto target = exchange->req.target();
+        if (!router_.empty() && router_.match(std::string_view(target.data(), target.size()), exchange->route)) {
+            api = exchange->route.api;
+        }
 
-        // 使用线程池执行（替代std::thread，减少线程创建开销）
-        net::post(thread_pool_, [self]() {
-            if (self->apis_.empty()) {
-                self->res_.body() = eval(self->req_.body());
-            } else {
-                auto it = self->apis_.find(self->req_.target());
-                if (it != self->apis_.end())
-                {
-                    self->res_.body() = value_to_string(executor.copy().execute_api(it->second.get()));
-                }
-                else
-                {
-                    self->res_.result(http::status::not_found);
-                    self->res_.body() = "Not Found (on port " + std::to_string(self->port_) + ")";
-                }
+        // 常量 api：直接在 I/O 线程上发送预先序列化的响应，不进入线程池
+        auto constant = api ? responses_.find(api) : responses_.end();
+        if (constant != responses_.end() && exchange->req.version() == 11 && !closing_)
+        {
+            exchange->raw = &constant->second;
+            exchange->ready = true;
+            do_write();
+            do_read();
+            return;
+        }
+
+        exchange->res = http::response<http::string_body>{http::status::ok, exchange->req.version()};
+        exchange->res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        exchange->res.set(http::field::content_type, "application/json; charset=utf-8");
+
+        // 耗时短的 api 直接执行，省去往返线程池的两次跨线程交接；其余在进程共享的线程池中执行
+        if (api) {
+            exchange->function = executor.api_function(api);
+        }
+        if (!router_.empty() && (!exchange->function ||
+                               exchange->function->cost_ns < Listener::inline_threshold.count())) {
+            process(exchange, api);
+        } else {
+            auto self(shared_from_this());
+            WorkerPool::instance().submit([self, exchange, api]() {
+                self->process(exchange, api);
+            });
+        }
+
+        // 流水线：执行期间继续读取后面的请求
+        do_read();
+    }
+
+    // 生成响应：api 为空时是 eval 模式的请求或者找不到的路径
+    void process(const std::shared_ptr<Exchange>& exchange, const APINode* api)
+    {
+        if (router_.empty()) {
+            exchange->res.body() = eval(exchange->req.body());
+            complete(exchange);
+            return;
+        }
+
+        if (!api) {
+            exchange->res.result(http::status::not_found);
+            exchange->res.body() = "Not Found (on port " + std::to_string(port_) + ")";
+            complete(exchange);
+            return;
+        }
+
+        exchange->exe.emplace(executor.copy());
+        exchange->exe->use_arena(exchange->arena);
+        execute(exchange, api, {});
+    }
+
+    // 执行 api 直到完成或在 <- 处挂起（api 为空时表示以 flights 继续挂起的执行）
+    // 挂起时不占用线程池：请求由 HttpClient 并发发出（与其他会话在途的相同请求合并），全部响应到达后再回到线程池继续执行
+    void execute(const std::shared_ptr<Exchange>& exchange, const APINode* api, Singleflight::Flights flights)
+    {
+        auto started = std::chrono::steady_clock::now();
+        try {
+            Value result;
+            bool done = api ? exchange->exe->execute_api(exchange->route, result)
+                            : exchange->exe->resume(std::move(flights), result);
+            if (!done) {
+                // 会挂起的 api 不在 I/O 线程上执行
+                exchange->function->cost_ns = UINT32_MAX;
+
+                auto self(shared_from_this());
+                Singleflight::instance().async_get(exchange->exe->pending_urls(),
+                    [self, exchange](Singleflight::Flights flights) {
+                        WorkerPool::instance().submit([self, exchange, flights = std::move(flights)]() mutable {
+                            self->execute(exchange, nullptr, std::move(flights));
+                        });
+                    });
+                return;
+            }
+            write_json(exchange->res.body(), result, Listener::response_indent);
+
+            // 一次执行完成（没有挂起）时，按执行与序列化的耗时更新滑动平均
+            // 有参数（路由参数）的 api 耗时取决于输入，某次测得很快不代表下次也快（如循环次数来自路径），
+            // 只有静态判定为耗时有上限的才在 I/O 线程上执行（cost_ns 为 0），其余总是交给线程池
+            if (api && exchange->function->parameters.empty() && exchange->function->cost_ns != 0) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+                auto sample = static_cast<uint32_t>(std::min<int64_t>(elapsed, UINT32_MAX - 1));
+                uint32_t cost = exchange->function->cost_ns;
+                exchange->function->cost_ns = cost == UINT32_MAX ? sample : cost - cost / 8 + sample / 8;
             }
+        } catch (const UpstreamError& e) {
+            // <- 的请求失败或超时：挂起的请求以错误恢复，不会一直占着连接
+            exchange->res.result(e.timed_out() ? http::status::gateway_timeout : http::status::bad_gateway);
+            exchange->res.body() = e.what();
+        } catch (const std::runtime_error& e) {
+            exchange->res.result(http::status::internal_server_error);
+            exchange->res.body() = e.what();
+        }
+        // 响应已序列化，释放本次请求的值
+        exchange->exe.reset();
+        exchange->arena.reset();
+        complete(exchange);
+    }
 
+    // 生成响应后回到连接的 strand 上写回（在 I/O 线程上执行时直接写回）
+    void complete(const std::shared_ptr<Exchange>& exchange)
+    {
+        exchange->res.prepare_payload();
+        auto self(shared_from_this());
+        net::dispatch(socket_.get_executor(), [self, exchange]() {
+            exchange->ready = true;
+            self->do_write();
+        });
+    }
 
+    // 按请求的顺序写回队首已生成的响应
+    void do_write()
+    {
+        if (writing_ || queue_.empty() || !queue_.front()->ready) {
+            return;
+        }
+        writing_ = true;
 
-            self->res_.prepare_payload();
-            self->res_.keep_alive(self->req_.keep_alive());
+        auto self(shared_from_this());
+        auto on_write = [self](beast::error_code ec, std::size_t bytes_transferred)
+        {
+            boost::ignore_unused(bytes_transferred);
+            self->writing_ = false;
+            if (ec) {
+                // 处理错误（如客户端断开连接）：丢弃其余响应
+                self->closing_ = true;
+                self->queue_.clear();
+                beast::error_code ec_close;
+                self->socket_.close(ec_close);
+                return;
+            }
 
-            // 异步发送响应
-            http::async_write(self->socket_, self->res_,
-                [self](beast::error_code ec, std::size_t bytes_transferred)
-                {
-                    boost::ignore_unused(bytes_transferred);
-                    if (ec) {
-                        // 处理错误（如客户端断开连接）
-                        return;
-                    }
+            auto done = std::move(self->queue_.front());
+            self->queue_.pop_front();
+            done->req = {};
+            done->res = {};
+            done->raw = nullptr;
+            done->function = nullptr;
+            done->ready = false;
+            self->spare_.push_back(std::move(done));
 
-                    // 发送完成后关闭socket
-                    beast::error_code ec_close;
-                    self->socket_.shutdown(tcp::socket::shutdown_send, ec_close);
-                }
-            );
+            self->do_write();
+            self->do_read();
+            self->arm_idle_timer();
+            self->finish_if_idle();
+        };
+
+        const auto& exchange = queue_.front();
+        if (exchange->raw) {
+            net::async_write(socket_, net::buffer(*exchange->raw), std::move(on_write));
+            return;
+        }
+        // 关闭前的最后一个响应告知客户端不再保持连接
+        exchange->res.keep_alive(!(closing_ && queue_.size() == 1));
+        http::async_write(socket_, exchange->res, std::move(on_write));
+    }
+
+    // 空闲超时：连接上没有待处理的请求时，等待下一个请求的最长时间，超时后关闭连接
+    void arm_idle_timer()
+    {
+        if (!reading_ || writing_ || !queue_.empty()) {
+            return;
+        }
+        auto self(shared_from_this());
+        idle_timer_.expires_after(Listener::keep_alive_timeout);
+        idle_timer_.async_wait([self](beast::error_code ec) {
+            if (ec || self->writing_ || !self->queue_.empty()) {
+                return;
+            }
+            // 取消正在等待的读取，由读取的回调结束会话
+            beast::error_code ec_close;
+            self->socket_.close(ec_close);
         });
     }
+
+    // 不再读取且响应都已写回时关闭连接
+    void finish_if_idle()
+    {
+        if (!closing_ || reading_ || writing_ || !queue_.empty()) {
+            return;
+        }
+        idle_timer_.cancel();
+        beast::error_code ec_close;
+        socket_.shutdown(tcp::socket::shutdown_send, ec_close);
+    }
 };
 
 void Listener::run()
@@ -133,13 +339,26 @@ void Listener::on_accept(beast::error_code ec, tcp::socket socket)
     else
     {
         // 创建新会话并运行，传递端口号
-        std::make_shared<Session>(std::move(socket), port_, this->get_apis(), http_thread_pool_)->run();
+        std::make_shared<Session>(std::move(socket), port_, this->get_router(), this->get_responses())->run();
     }
 
     // 接受下一个连接
     do_accept();
 }
 
+std::string Listener::serialize_response(const std::string& body)
+{
+    http::response<http::string_body> res{http::status::ok, 11};
+    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(http::field::content_type, "application/json; charset=utf-8");
+    res.body() = body;
+    res.prepare_payload();
+
+    std::ostringstream oss;
+    oss << res;
+    return oss.str();
+}
+
 // 错误处理
 void Listener::fail(beast::error_code ec, char const* what)
 {
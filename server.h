@@ -6,8 +6,10 @@
 #define GLUE_SERVER_H
 
 #include "executor.h"
+#include "router.h"
 #include <boost/beast.hpp>
 #include <boost/asio.hpp>
+#include <chrono>
 #include <iostream>
 #include <memory>
 
@@ -25,18 +27,47 @@ class Listener : public std::enable_shared_from_this<Listener>
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
     unsigned short port_;  // 监听的端口号
-    std::unordered_map<std::string, std::unique_ptr<APINode>> apis;
-    net::thread_pool http_thread_pool_;
+    const std::unordered_map<std::string, std::unique_ptr<APINode>>& apis;  // 同一端口的各监听器共享
+
+    // 由 apis 的路径模板构建的路由
+    Router router_;
+
+    // 常量 api 预先序列化好的完整响应（状态行、头部和响应体）
+    std::unordered_map<const APINode*, std::string> responses_;
 
 public:
+    // 响应体 JSON 的缩进，负数为紧凑格式（--debug 时为 4）
+    static inline int response_indent = -1;
+
+    // 入站连接的保持：空闲超时、每个连接最多处理的请求数，以及流水线上最多同时排队的请求数
+    static inline std::chrono::seconds keep_alive_timeout{30};
+    static inline size_t max_keep_alive_requests = 1000;
+    static inline size_t pipeline_depth = 16;
+
+    // 平均耗时低于该值的无参数 api 直接在 I/O 线程上执行，不交给线程池（0 表示都交给线程池）
+    static inline std::chrono::nanoseconds inline_threshold{std::chrono::microseconds(50)};
+
+    // 反应器线程数：每个线程运行独立的 io_context，并为每个端口打开一个 SO_REUSEPORT 的监听器
+    static inline size_t reactors = 1;
+
     /**
      * 构造函数
      * @param ioc IO上下文
      * @param endpoint 要监听的端点(地址+端口)
+     * @param apis 端口上的 api（键为路径模板），须比监听器活得久；模板无效或冲突时抛出 RouterError
+     * @param bodies 常量 api 的响应体
     */
-    Listener(net::io_context& ioc, tcp::endpoint endpoint, std::unordered_map<std::string, std::unique_ptr<APINode>>&& apis)
-        : ioc_(ioc), acceptor_(ioc), port_(endpoint.port()), apis(std::move(apis)), http_thread_pool_(4)
+    Listener(net::io_context& ioc, tcp::endpoint endpoint, const std::unordered_map<std::string, std::unique_ptr<APINode>>& apis,
+             const std::unordered_map<std::string, std::string>& bodies = {})
+        : ioc_(ioc), acceptor_(ioc), port_(endpoint.port()), apis(apis)
     {
+        for (const auto& [path, api] : apis) {
+            router_.add(path, api.get());
+        }
+        for (const auto& [path, body] : bodies) {
+            responses_[apis.at(path).get()] = serialize_response(body);
+        }
+
         beast::error_code ec;
 
         // 打开 acceptor
@@ -55,6 +86,14 @@ public:
             return;
         }
 
+        // 多个反应器各自监听同一端口，由内核在它们之间分配新连接
+        acceptor_.set_option(net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true), ec);
+        if(ec)
+        {
+            fail(ec, ("set_option reuse_port (port " + std::to_string(port_) + ")").c_str());
+            return;
+        }
+
         // 绑定到服务器地址
         acceptor_.bind(endpoint, ec);
         if(ec)
@@ -79,10 +118,15 @@ public:
      */
     void run();
 
-    // 提供给 Session 访问 apis 的接口（const，避免 Session 修改）
-    const std::unordered_map<std::string, std::unique_ptr<APINode>>& get_apis() const
+    // 提供给 Session 匹配 api 的接口（const，避免 Session 修改）
+    const Router& get_router() const
+    {
+        return router_;
+    }
+
+    const std::unordered_map<const APINode*, std::string>& get_responses() const
     {
-        return apis;
+        return responses_;
     }
 
 private:
@@ -98,6 +142,12 @@ private:
      */
     void on_accept(beast::error_code ec, tcp::socket socket);
 
+    /**
+     * 按动态 api 相同的头部序列化一个 200 响应
+     * @param body 响应体
+     */
+    static std::string serialize_response(const std::string& body);
+
     /**
      * 错误处理函数
      * @param ec 错误码
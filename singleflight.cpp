@@ -0,0 +1,109 @@
+//
+// Created by ezzno on 2025/9/22.
+//
+
+#include <future>
+#include <iomanip>
+#include <sstream>
+
+#include "cache.h"
+#include "singleflight.h"
+
+std::shared_ptr<const Value> Singleflight::Flight::value(std::chrono::seconds ttl) {
+    std::call_once(decoded_, [&] {
+        std::shared_ptr<const Value> value;
+        if (ttl.count() > 0) {
+            value = ResponseCache::instance().store(url_, response_.body, ttl);
+        }
+        value_ = value ? std::move(value) : ResponseCache::decode(response_.body);
+    });
+    return value_;
+}
+
+Singleflight& Singleflight::instance() {
+    static Singleflight singleflight;
+    return singleflight;
+}
+
+void Singleflight::async_get(const std::vector<std::string>& urls, Callback callback) {
+    // 各请求的回调都在 HttpClient 的 I/O 线程上执行，计数不需要同步
+    struct Batch {
+        Flights flights;
+        size_t remaining;
+        Callback callback;
+    };
+    auto batch = std::make_shared<Batch>(Batch{Flights(urls.size()), urls.size(), std::move(callback)});
+    if (urls.empty()) {
+        batch->callback({});
+        return;
+    }
+
+    // 没有在途的相同请求时由本次调用发出
+    Flights leaders;
+    std::vector<std::string> leader_urls;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < urls.size(); ++i) {
+            auto& flight = flights_[urls[i]];
+            if (!flight) {
+                flight = std::make_shared<Flight>();
+                flight->url_ = urls[i];
+                leaders.push_back(flight);
+                leader_urls.push_back(urls[i]);
+            }
+            ++flight->waiters_;
+            flight->callbacks_.push_back([batch, i, flight] {
+                batch->flights[i] = flight;
+                if (--batch->remaining == 0) {
+                    batch->callback(std::move(batch->flights));
+                }
+            });
+        }
+    }
+    requests_ += urls.size();
+    fetches_ += leaders.size();
+
+    if (!leaders.empty()) {
+        HttpClient::instance().async_get(std::move(leader_urls),
+            [this, leaders = std::move(leaders)](std::vector<HttpResponse> responses) {
+                for (size_t i = 0; i < leaders.size(); ++i) {
+                    complete(leaders[i], std::move(responses[i]));
+                }
+            });
+    }
+}
+
+void Singleflight::complete(const std::shared_ptr<Flight>& flight, HttpResponse response) {
+    std::vector<std::function<void()>> callbacks;
+    {
+        // 移除后到达的相同请求重新发出，不会再加入这个请求
+        std::lock_guard<std::mutex> lock(mutex_);
+        flights_.erase(flight->url_);
+        flight->response_ = std::move(response);
+        callbacks = std::move(flight->callbacks_);
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
+
+Singleflight::Flights Singleflight::get(const std::vector<std::string>& urls) {
+    std::promise<Flights> promise;
+    auto flights = promise.get_future();
+    async_get(urls, [&promise](Flights result) { promise.set_value(std::move(result)); });
+    return flights.get();
+}
+
+std::string Singleflight::report() const {
+    // requests_ 先于 fetches_ 增加，按相反的顺序读取保证 fetches 不超过 requests
+    uint64_t fetches = fetches_;
+    uint64_t requests = requests_;
+    uint64_t coalesced = requests - fetches;
+
+    std::ostringstream oss;
+    oss << "upstream requests: " << requests << ", fetched: " << fetches << ", coalesced: " << coalesced;
+    if (requests > 0) {
+        oss << " (" << std::fixed << std::setprecision(1) << 100.0 * coalesced / requests << "%)";
+    }
+    return oss.str();
+}
@@ -0,0 +1,85 @@
+//
+// Created by ezzno on 2025/9/22.
+//
+
+#ifndef GLUE_SINGLEFLIGHT_H
+#define GLUE_SINGLEFLIGHT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "client.h"
+#include "value.h"
+
+// 上游请求合并（<- 使用）：同一 URL 同时只有一个请求在途，期间到达的相同请求不再发出，等它完成后共享响应
+// 合并的响应体只解码一次，解码后的值在所有等待者间共享
+class Singleflight {
+public:
+    // 一次在途的请求，完成后交给所有等待者
+    class Flight {
+        friend class Singleflight;
+
+        std::string url_;
+        HttpResponse response_;
+        size_t waiters_ = 0;                            // 加入的调用者数，完成后不再变化
+        std::vector<std::function<void()>> callbacks_;  // 完成时调用，由 Singleflight 的锁保护
+
+        std::once_flag decoded_;
+        std::shared_ptr<const Value> value_;
+
+    public:
+        [[nodiscard]] const HttpResponse& response() const {
+            return response_;
+        }
+
+        // 是否有多个调用者共享这个响应
+        [[nodiscard]] bool shared() const {
+            return waiters_ > 1;
+        }
+
+        // 只有一个调用者时取走响应体，由它自己解码
+        std::string take_body() {
+            return std::move(response_.body);
+        }
+
+        // 共享的解码结果：第一个调用者解码，其余调用者等待并共享；ttl 大于 0 时同时放入 ResponseCache
+        std::shared_ptr<const Value> value(std::chrono::seconds ttl);
+    };
+
+    using Flights = std::vector<std::shared_ptr<Flight>>;
+    using Callback = std::function<void(Flights flights)>;
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;  // 在途的请求
+
+    // 统计：<- 请求数，以及实际发往上游的请求数
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> fetches_{0};
+
+    Singleflight() = default;
+
+    // 由 HttpClient 的 I/O 线程调用：移除在途记录并通知等待者
+    void complete(const std::shared_ptr<Flight>& flight, HttpResponse response);
+
+public:
+    static Singleflight& instance();
+
+    // 同 HttpClient::async_get，与在途的相同请求合并，全部完成后在 HttpClient 的 I/O 线程上调用 callback
+    void async_get(const std::vector<std::string>& urls, Callback callback);
+
+    // 阻塞等待一组请求全部完成；不能在 callback 中调用
+    Flights get(const std::vector<std::string>& urls);
+
+    // 合并率统计
+    [[nodiscard]] std::string report() const;
+};
+
+#endif // GLUE_SINGLEFLIGHT_H
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+#
+# 启用和关闭全部优化 pass 时，同一程序的局部变量槽位和输出须相同
+# 用法：tests/passes.sh <ro-glue 路径>
+#
+set -euo pipefail
+
+RO_GLUE=${1:-build/ro-glue}
+HERE=$(cd "$(dirname "$0")" && pwd)
+status=0
+
+compare() {
+    local what=$1 optimized=$2 unoptimized=$3
+    if [ "$optimized" != "$unoptimized" ]; then
+        echo "$what differs between the default passes and --passes=" >&2
+        diff <(echo "$optimized") <(echo "$unoptimized") >&2 || true
+        status=1
+    fi
+}
+
+# --debug 输出中每个函数的 LOCALS 行
+locals() {
+    "$RO_GLUE" --debug "$@" "$HERE/passes.ro" 2>&1 | grep -E '^ *(FUNCTION|LOCALS)'
+}
+
+compare "LOCALS" "$(locals)" "$(locals --passes=)"
+compare "output" "$("$RO_GLUE" "$HERE/passes.ro" 2>&1)" "$("$RO_GLUE" --passes= "$HERE/passes.ro" 2>&1)"
+exit $status
@@ -2,9 +2,12 @@
 // Created by ezzno on 2025/8/31.
 //
 
+#include "bytecode.h"
 #include "parser.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <execinfo.h>  // 非标准库，但但在Linux/macOS上普遍存在
 
 // AST节点的to_string实现
@@ -31,6 +34,7 @@ std::string ExprNode::to_string(int indent) const {
         case OpType::CONSTANT_INT: result += "CONSTANT_INT(" + value + ")"; break;
         case OpType::CONSTANT_FLOAT: result += "CONSTANT_FLOAT(" + value + ")"; break;
         case OpType::CONSTANT_STRING: result += "CONSTANT_STRING(" + value + ")"; break;
+        case OpType::CONSTANT_VALUE: result += "CONSTANT_VALUE(" + value + ")"; break;
         case OpType::IDENTIFIER: result += "IDENTIFIER(" + value + ")"; break;
         // 新增数组类型的字符串表示
         case OpType::ARRAY_LITERAL: {
@@ -158,4 +162,146 @@ std::string ProgramNode::to_string(int indent) const {
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+const char* opcode_name(OpCode op) {
+    switch (op) {
+        case OpCode::CONST: return "CONST";
+        case OpCode::LOAD_LOCAL: return "LOAD_LOCAL";
+        case OpCode::STORE_LOCAL: return "STORE_LOCAL";
+        case OpCode::LOAD_GLOBAL: return "LOAD_GLOBAL";
+        case OpCode::STORE_GLOBAL: return "STORE_GLOBAL";
+        case OpCode::POP: return "POP";
+        case OpCode::FIELD: return "FIELD";
+        case OpCode::ELEMENT: return "ELEMENT";
+        case OpCode::INDEX: return "INDEX";
+        case OpCode::CALL: return "CALL";
+        case OpCode::ADD: return "ADD";
+        case OpCode::SUB: return "SUB";
+        case OpCode::MUL: return "MUL";
+        case OpCode::DIV: return "DIV";
+        case OpCode::EQ: return "EQ";
+        case OpCode::NEQ: return "NEQ";
+        case OpCode::LT: return "LT";
+        case OpCode::GT: return "GT";
+        case OpCode::LE: return "LE";
+        case OpCode::GE: return "GE";
+        case OpCode::AND: return "AND";
+        case OpCode::OR: return "OR";
+        case OpCode::NOT: return "NOT";
+        case OpCode::ARRAY: return "ARRAY";
+        case OpCode::OBJECT: return "OBJECT";
+        case OpCode::CURL: return "CURL";
+        case OpCode::FETCH: return "FETCH";
+        case OpCode::AWAIT: return "AWAIT";
+        case OpCode::JUMP: return "JUMP";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::EACH: return "EACH";
+        case OpCode::PRINT: return "PRINT";
+        case OpCode::RETURN: return "RETURN";
+    }
+    return "UNKNOWN";
+}
+
+// 字节码反汇编
+std::string Chunk::to_string(int indent) const {
+    std::string ind(indent, ' ');
+    std::ostringstream oss;
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto& ins = code[i];
+        oss << ind << std::setw(4) << i << "  " << std::left << std::setw(14) << opcode_name(ins.op) << std::right;
+
+        switch (ins.op) {
+            case OpCode::CONST:
+            case OpCode::LOAD_GLOBAL:
+            case OpCode::STORE_GLOBAL:
+            case OpCode::FIELD: {
+                json j;
+                to_json(j, constants[ins.a]);
+                oss << ins.a << " (" << j.dump() << ")";
+                break;
+            }
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::EACH:
+                oss << "-> " << ins.a;
+                break;
+            case OpCode::LOAD_LOCAL:
+            case OpCode::STORE_LOCAL:
+            case OpCode::ELEMENT:
+            case OpCode::CALL:
+            case OpCode::ARRAY:
+            case OpCode::OBJECT:
+            case OpCode::PRINT:
+                oss << ins.a;
+                break;
+            case OpCode::FETCH:
+                oss << ins.a << (ins.b ? " cache" : "");
+                break;
+            case OpCode::CURL:
+                oss << (ins.b ? "cache" : "");
+                break;
+            default:
+                break;
+        }
+        oss << "\n";
+    }
+
+    return oss.str();
+}
+
+// 局部变量槽位表
+static std::string slots_to_string(const std::vector<std::string>& slots, int indent) {
+    if (slots.empty()) {
+        return "";
+    }
+
+    std::string result = std::string(indent, ' ') + "LOCALS";
+    for (size_t i = 0; i < slots.size(); ++i) {
+        result += " " + std::to_string(i) + ":" + slots[i];
+    }
+    return result + "\n";
+}
+
+std::string Function::to_string(int indent) const {
+    std::string ind(indent, ' ');
+    std::string result = ind + "FUNCTION " + name + "(";
+
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        result += parameters[i];
+        if (i < parameters.size() - 1) {
+            result += ", ";
+        }
+    }
+    result += ")\n";
+    result += slots_to_string(slots, indent + 4);
+    result += chunk.to_string(indent + 4);
+
+    return result;
+}
+
+std::string Module::to_string(int indent) const {
+    std::string ind(indent, ' ');
+    std::string result = ind + "MODULE\n";
+
+    for (const auto& func : functions) {
+        result += func->to_string(indent + 4);
+    }
+
+    // 按路径排序，保证输出稳定
+    std::vector<const Function*> sorted;
+    for (const auto& [node, api] : apis) {
+        sorted.push_back(api.get());
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Function* a, const Function* b) {
+        return a->name < b->name;
+    });
+    for (const auto* api : sorted) {
+        result += ind + "    API " + api->name + "\n";
+        result += slots_to_string(api->slots, indent + 8);
+        result += api->chunk.to_string(indent + 8);
+    }
+
+    return result;
+}
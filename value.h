@@ -0,0 +1,297 @@
+//
+// Created by ezzno on 2025/9/12.
+//
+
+#ifndef GLUE_VALUE_H
+#define GLUE_VALUE_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+
+#define NULL_VALUE 0
+
+using json = nlohmann::json;
+
+struct Function;
+struct LazyValue;
+class Value;
+
+// 对象的键可以直接用 std::string、string_view 查找，不构造临时的键
+struct KeyHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+};
+
+struct KeyEqual {
+    using is_transparent = void;
+    bool operator()(std::string_view l, std::string_view r) const noexcept { return l == r; }
+};
+
+// 数组与对象使用多态分配器：在 Arena 中创建时，元素缓冲区、哈希节点和键都从 Arena 的内存资源分配
+using Values = std::pmr::vector<Value>;
+using ValueMap = std::pmr::unordered_map<std::pmr::string, Value, KeyHash, KeyEqual>;
+
+// 支持的数据类型：8 字节的值，低 3 位为类型标记
+// int、float、bool 存放在高 32 位；字符串、数组、对象、函数是 8 字节对齐的指针，标记占用指针的低 3 位
+// 值不拥有所指向的数据：字符串、数组、对象分配在 Arena 中（字面量和名字驻留在进程级的表中），复制值只复制 8 字节
+// LAZY 是尚未解码的 JSON 数组或对象（<- 的结果），见 decoder.h
+class Value {
+public:
+    enum class Type : uint8_t { INT, FLOAT, BOOL, STRING, ARRAY, OBJECT, FUNCTION, LAZY };
+
+private:
+    static constexpr uint64_t TAG_MASK = 7;
+
+    uint64_t bits_;
+
+    constexpr Value(Type type, uint64_t payload) : bits_(payload | static_cast<uint64_t>(type)) {}
+
+    static Value pointer(Type type, const void* p) {
+        auto bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p));
+        assert((bits & TAG_MASK) == 0);
+        return {type, bits};
+    }
+
+    [[nodiscard]] uint32_t immediate() const { return static_cast<uint32_t>(bits_ >> 32); }
+
+    template<typename T>
+    [[nodiscard]] T* address() const { return reinterpret_cast<T*>(static_cast<uintptr_t>(bits_ & ~TAG_MASK)); }
+
+public:
+    constexpr Value() : Value(0) {}
+    constexpr Value(int i) : Value(Type::INT, static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) {}
+    constexpr Value(float f) : Value(Type::FLOAT, static_cast<uint64_t>(std::bit_cast<uint32_t>(f)) << 32) {}
+    constexpr Value(bool b) : Value(Type::BOOL, static_cast<uint64_t>(b) << 32) {}
+
+    // 指针不能隐式转换为 bool 值，须使用下面的工厂函数
+    template<typename T>
+    Value(T*) = delete;
+
+    // s 须比值活得久（分配在 Arena 中或是驻留字符串）
+    static Value string(const std::string* s) { return pointer(Type::STRING, s); }
+    static Value array(Values* array) { return pointer(Type::ARRAY, array); }
+    static Value object(ValueMap* object) { return pointer(Type::OBJECT, object); }
+    static Value function(const Function* func) { return pointer(Type::FUNCTION, func); }
+    static Value lazy(const LazyValue* lazy) { return pointer(Type::LAZY, lazy); }
+
+    [[nodiscard]] Type type() const { return static_cast<Type>(bits_ & TAG_MASK); }
+
+    [[nodiscard]] bool is_int() const { return type() == Type::INT; }
+    [[nodiscard]] bool is_float() const { return type() == Type::FLOAT; }
+    [[nodiscard]] bool is_bool() const { return type() == Type::BOOL; }
+    [[nodiscard]] bool is_string() const { return type() == Type::STRING; }
+    [[nodiscard]] bool is_array() const { return type() == Type::ARRAY; }
+    [[nodiscard]] bool is_object() const { return type() == Type::OBJECT; }
+    [[nodiscard]] bool is_function() const { return type() == Type::FUNCTION; }
+    [[nodiscard]] bool is_lazy() const { return type() == Type::LAZY; }
+
+    // 调用者须先检查类型
+    [[nodiscard]] int as_int() const { return static_cast<int>(immediate()); }
+    [[nodiscard]] float as_float() const { return std::bit_cast<float>(immediate()); }
+    [[nodiscard]] bool as_bool() const { return immediate() != 0; }
+    [[nodiscard]] const std::string& as_string() const { return *address<const std::string>(); }
+    [[nodiscard]] Values& as_array() const { return *address<Values>(); }
+    [[nodiscard]] ValueMap& as_object() const { return *address<ValueMap>(); }
+    [[nodiscard]] const Function* as_function() const { return address<const Function>(); }
+    [[nodiscard]] const LazyValue& as_lazy() const { return *address<const LazyValue>(); }
+
+    // 字符串按内容比较，数组、对象、函数按地址比较，延迟值按所在文档与位置比较，int 与 float 视为不同类型
+    friend bool operator==(const Value& l, const Value& r);
+};
+
+static_assert(sizeof(Value) == 8, "Value must fit in a register");
+
+struct JsonDocument;
+
+// 延迟解码的 JSON 数组或对象：只记录在文档结构索引中的位置
+struct LazyValue {
+    const JsonDocument* document;
+    uint32_t position;
+    mutable uint32_t accesses = 0;       // 按路径访问的次数
+    mutable Value decoded = NULL_VALUE;  // 已解码的一层（数组或对象），未解码时为 int
+};
+
+// 解码延迟值的一层并缓存：返回数组或对象，其中的子数组、子对象仍是延迟值（定义在 decoder.cpp）
+Value materialize(const LazyValue& lazy);
+
+inline bool operator==(const Value& l, const Value& r) {
+    if (l.type() != r.type()) {
+        return false;
+    }
+    switch (l.type()) {
+        case Value::Type::FLOAT:
+            return l.as_float() == r.as_float();
+        case Value::Type::STRING:
+            return l.bits_ == r.bits_ || l.as_string() == r.as_string();
+        case Value::Type::LAZY:
+            return l.as_lazy().document == r.as_lazy().document && l.as_lazy().position == r.as_lazy().position;
+        default:
+            return l.bits_ == r.bits_;
+    }
+}
+
+// 向前声明转换函数
+inline std::string value_to_string(const Value& value, int indent = -1);
+inline void to_json(json& j, const Values& vs);
+inline void to_json(json& j, const ValueMap& vm);
+
+// 自定义序列化函数，用于处理 Value（函数序列化为 null）
+inline void to_json(json& j, const Value& v) {
+    switch (v.type()) {
+        case Value::Type::INT: j = v.as_int(); break;
+        case Value::Type::FLOAT: j = v.as_float(); break;
+        case Value::Type::BOOL: j = v.as_bool(); break;
+        case Value::Type::STRING: j = v.as_string(); break;
+        case Value::Type::ARRAY: to_json(j, v.as_array()); break;
+        case Value::Type::OBJECT: to_json(j, v.as_object()); break;
+        case Value::Type::FUNCTION: j = nullptr; break;
+        case Value::Type::LAZY: to_json(j, materialize(v.as_lazy())); break;
+    }
+}
+
+// 自定义序列化函数，用于处理 Values vector
+inline void to_json(json& j, const Values& vs) {
+    j = json::array();
+    for (const auto& v : vs) {
+        json temp;
+        to_json(temp, v);
+        j.push_back(temp);
+    }
+}
+
+// 自定义序列化函数，用于处理 ValueMap unordered_map
+inline void to_json(json& j, const ValueMap& vm) {
+    j = json::object();
+    for (const auto& [key, value] : vm) {
+        json temp;
+        to_json(temp, value);
+        j[std::string(key)] = temp;
+    }
+}
+
+// 直接将 value 以 JSON 追加到 out 末尾，不构建中间的 json 对象
+// indent < 0 时输出紧凑格式，否则每层缩进 indent 个空格；函数输出为 null
+inline void write_json(std::string& out, const Value& value, int indent = -1, int depth = 0) {
+    auto newline = [&](int level) {
+        if (indent >= 0) {
+            out += '\n';
+            out.append(static_cast<size_t>(indent) * level, ' ');
+        }
+    };
+
+    auto write_string = [&](std::string_view s) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        out += '"';
+        for (char c : s) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out += "\\u00";
+                        out += HEX[(c >> 4) & 0xf];
+                        out += HEX[c & 0xf];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    };
+
+    switch (value.type()) {
+        case Value::Type::INT: {
+            char buffer[16];
+            out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value.as_int()).ptr);
+            break;
+        }
+        case Value::Type::FLOAT: {
+            float f = value.as_float();
+            if (!std::isfinite(f)) {
+                out += "null";
+                break;
+            }
+            // 最短的可还原表示，整数值保留 .0 以区分 int
+            char buffer[32];
+            char* end = std::to_chars(buffer, buffer + sizeof(buffer), f).ptr;
+            out.append(buffer, end);
+            if (std::find_if(buffer, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+                out += ".0";
+            }
+            break;
+        }
+        case Value::Type::BOOL:
+            out += value.as_bool() ? "true" : "false";
+            break;
+        case Value::Type::STRING:
+            write_string(value.as_string());
+            break;
+        case Value::Type::ARRAY: {
+            const auto& array = value.as_array();
+            out += '[';
+            for (size_t i = 0; i < array.size(); ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                newline(depth + 1);
+                write_json(out, array[i], indent, depth + 1);
+            }
+            if (!array.empty()) {
+                newline(depth);
+            }
+            out += ']';
+            break;
+        }
+        case Value::Type::OBJECT: {
+            const auto& object = value.as_object();
+            out += '{';
+            bool first = true;
+            for (const auto& [key, elem] : object) {
+                if (!first) {
+                    out += ',';
+                }
+                first = false;
+                newline(depth + 1);
+                write_string(key);
+                out += indent >= 0 ? ": " : ":";
+                write_json(out, elem, indent, depth + 1);
+            }
+            if (!object.empty()) {
+                newline(depth);
+            }
+            out += '}';
+            break;
+        }
+        case Value::Type::FUNCTION:
+            out += "null";
+            break;
+        case Value::Type::LAZY:
+            write_json(out, materialize(value.as_lazy()), indent, depth);
+            break;
+    }
+}
+
+inline std::string value_to_string(const Value& value, int indent) {
+    std::string out;
+    write_json(out, value, indent);
+    return out;
+}
+
+#endif // GLUE_VALUE_H
@@ -0,0 +1,107 @@
+//
+// Created by ezzno on 2025/9/24.
+//
+
+#include <algorithm>
+
+#include "workers.h"
+
+namespace {
+
+// 当前线程所属的线程池及其队列序号（非工作线程为空）
+thread_local const WorkerPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // namespace
+
+WorkerPool& WorkerPool::instance() {
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::start(size_t threads) {
+    std::call_once(started_, [this, threads] {
+        const size_t count = std::max<size_t>(threads, 1);
+        for (size_t i = 0; i < count; ++i) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < count; ++i) {
+            threads_.emplace_back([this, i] { run(i); });
+        }
+    });
+}
+
+void WorkerPool::submit(Task task) {
+    start(std::thread::hardware_concurrency());
+
+    // 先增加任务数（避免取走任务时计数为负）再检查休眠数，与 run 中的顺序相反，保证不会在有任务时全部休眠
+    ++pending_;
+    size_t index = current_pool == this ? current_index : next_++ % workers_.size();
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    if (sleepers_ > 0) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_one();
+    }
+}
+
+bool WorkerPool::take(size_t index, Task& task) {
+    {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    Task task;
+    while (true) {
+        if (take(index, task)) {
+            --pending_;
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        ++sleepers_;
+        idle_cv_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+        --sleepers_;
+        if (stopping_) {
+            return;
+        }
+    }
+}
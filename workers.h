@@ -0,0 +1,61 @@
+//
+// Created by ezzno on 2025/9/24.
+//
+
+#ifndef GLUE_WORKERS_H
+#define GLUE_WORKERS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 执行 api 的线程池（进程内共享，所有端口的监听器都提交到这里）
+// 每个工作线程有自己的任务队列：工作线程提交的任务放入自己的队列并优先执行（后进先出，缓存较热）
+// 其他线程提交的任务轮流放入各队列；自己的队列为空时从其他队列的另一端窃取，都没有任务时休眠
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::once_flag started_;
+
+    std::atomic<size_t> pending_{0};   // 所有队列中的任务数
+    std::atomic<size_t> next_{0};      // 外部提交轮流放入的队列
+    std::atomic<size_t> sleepers_{0};  // 休眠中的工作线程数
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    bool stopping_ = false;  // 由 idle_mutex_ 保护
+
+    WorkerPool() = default;
+
+    void run(size_t index);
+
+    // 取出一个任务：先从自己队列的尾部，再从其他队列的头部
+    bool take(size_t index, Task& task);
+
+public:
+    ~WorkerPool();
+
+    static WorkerPool& instance();
+
+    // 启动 threads 个工作线程，只能调用一次；未启动时第一次提交以硬件线程数启动
+    void start(size_t threads);
+
+    void submit(Task task);
+};
+
+#endif // GLUE_WORKERS_H